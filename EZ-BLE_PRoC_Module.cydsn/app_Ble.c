@@ -18,13 +18,91 @@
  * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
  * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
  */
+#include <string.h>
 #include "app_Ble.h"
 
+/* Largest written value an event holds. Every queued event carries this
+   much, it is not derived from CYBLE_GATT_MTU so that raising the MTU in the
+   BLE component cannot grow the queue unnoticed. */
+#define BLE_EVENT_DATA_SIZE 64u
+#if ((CYBLE_GATT_MTU - 3u) > BLE_EVENT_DATA_SIZE)
+#error "BLE_EVENT_DATA_SIZE must hold a write of CYBLE_GATT_MTU - 3 bytes"
+#endif
+
+/* BLE stack event with the parameters its handler needs, eventParam is only
+   valid inside the stack callback */
+typedef struct
+{
+	uint32 event;	 /* CYBLE_EVT_xxx */
+	uint32 time;	 /* time stamp of the callback */
+	uint16 value;	 /* busy status, encryption state, MTU, L2CAP result or attribute handle */
+	uint16 interval; /* connection interval (1.25 ms units) */
+	uint16 latency;	 /* slave latency */
+	uint16 len;		 /* length of the written value */
+	uint8 status;	 /* connection update status */
+	uint8 data[BLE_EVENT_DATA_SIZE];
+} BLE_EVENT_T;
+
+static BLE_EVENT_T bleQueue[APP_EVENT_QUEUE_DEPTH];
+static uint8 bleHead;  /* oldest event */
+static uint8 bleCount; /* number of events */
+
+static void dispatchBleEvent(const BLE_EVENT_T *bleEvent);
+
+/*******************************************************************************
+ * Function Name: bleEventPending
+ ********************************************************************************
+ * Summary:
+ *        This function returns the number of queued BLE events
+ *
+ * Parameters:
+ *  void
+ *
+ * Return:
+ *  uint8: queue depth
+ *
+ *******************************************************************************/
+uint8 bleEventPending(void)
+{
+	return bleCount;
+}
+
+/*******************************************************************************
+ * Function Name: handleBleEvent
+ ********************************************************************************
+ * Summary:
+ *        This function handles the oldest BLE event queued by AppCallBack(),
+ *        call from the main loop while bleEventPending() is non-zero
+ *
+ * Parameters:
+ *  void
+ *
+ * Return:
+ *  uint32: CYBLE_EVT_xxx handled
+ *
+ *******************************************************************************/
+uint32 handleBleEvent(void)
+{
+	BLE_EVENT_T *bleEvent = &bleQueue[bleHead];
+
+	/* The slot stays reserved while it is handled, in case the handler runs
+	the stack and AppCallBack() queues more events */
+	dispatchBleEvent(bleEvent);
+
+	bleHead = (bleHead + 1u) % APP_EVENT_QUEUE_DEPTH;
+	bleCount--;
+	return bleEvent->event;
+}
+
 /*******************************************************************************
  * Function Name: AppCallBack
  ********************************************************************************
  * Summary:
- *        Call back event function to handle varios events from BLE stack
+ *        Call back event function to handle varios events from BLE stack.
+ *        It only copies the event and its parameters into the event queue,
+ *        the work is done by handleBleEvent() from the main loop. An event
+ *        that finds the queue full is counted and dropped, it is never handled
+ *        inside the callback.
  *
  * Parameters:
  *  event:		event returned
@@ -36,27 +114,143 @@
  *******************************************************************************/
 void AppCallBack(uint32 event, void *eventParam)
 {
-	uint8 i;
+	BLE_EVENT_T *bleEvent = &bleQueue[(bleHead + bleCount) % APP_EVENT_QUEUE_DEPTH];
 	CYBLE_GATTS_WRITE_REQ_PARAM_T *wrReqParam;
+	CYBLE_GAP_CONN_PARAM_UPDATED_IN_CONTROLLER_T *connParam;
+	CYBLE_GATTS_PREP_WRITE_REQ_PARAM_T *prepWriteParam;
+
+	if (CYBLE_EVT_GATTS_PREP_WRITE_REQ == event)
+	{
+		/* The stack queues the parts, it wants the answer before returning */
+		prepWriteParam = (CYBLE_GATTS_PREP_WRITE_REQ_PARAM_T *)eventParam;
+		CyBle_GattsPrepWriteReqSupport(rxPrepareWrite(prepWriteParam->baseAddr[prepWriteParam->currentPrepWriteReqCount - 1u].handleValuePair.attrHandle));
+		return;
+	}
+
+	if (bleCount >= APP_EVENT_QUEUE_DEPTH)
+	{
+		/* The queue holds everything one CyBle_ProcessEvents() call reports,
+		getting here means APP_EVENT_QUEUE_DEPTH is too small */
+		eventStats.overflow++;
+		return;
+	}
+	bleEvent->event = event;
+	bleEvent->time = appTimerNow();
 
 	switch (event)
 	{
+	case CYBLE_EVT_STACK_ON:
+	case CYBLE_EVT_GAPP_ADVERTISEMENT_START_STOP:
+	case CYBLE_EVT_GAP_DEVICE_DISCONNECTED:
+	case CYBLE_EVT_GATT_CONNECT_IND:
+	case CYBLE_EVT_GAP_AUTH_REQ:
+		break;
+
+	case CYBLE_EVT_STACK_BUSY_STATUS:
+	case CYBLE_EVT_GAP_ENCRYPT_CHANGE:
+		bleEvent->value = *(uint8 *)eventParam;
+		break;
+
+	case CYBLE_EVT_L2CAP_CONN_PARAM_UPDATE_RSP:
+		bleEvent->value = *(uint16 *)eventParam;
+		break;
+
+	case CYBLE_EVT_GATTS_XCNHG_MTU_REQ:
+		bleEvent->value = ((CYBLE_GATT_XCHG_MTU_PARAM_T *)eventParam)->mtu;
+		break;
+
+	case CYBLE_EVT_GAP_DEVICE_CONNECTED:
+	case CYBLE_EVT_GAP_CONNECTION_UPDATE_COMPLETE:
+		connParam = (CYBLE_GAP_CONN_PARAM_UPDATED_IN_CONTROLLER_T *)eventParam;
+		bleEvent->status = connParam->status;
+		bleEvent->interval = connParam->connIntv;
+		bleEvent->latency = connParam->connLatency;
+		break;
+
+	case CYBLE_EVT_GATTS_WRITE_REQ:
+	case CYBLE_EVT_GATTS_WRITE_CMD_REQ:
+		wrReqParam = (CYBLE_GATTS_WRITE_REQ_PARAM_T *)eventParam;
+		bleEvent->value = wrReqParam->handleValPair.attrHandle;
+		bleEvent->len = (wrReqParam->handleValPair.value.len < BLE_EVENT_DATA_SIZE) ? wrReqParam->handleValPair.value.len : BLE_EVENT_DATA_SIZE;
+		memcpy(bleEvent->data, wrReqParam->handleValPair.value.val, bleEvent->len);
+		break;
+
+	case CYBLE_EVT_GATTS_EXEC_WRITE_REQ:
+		/* The parts are only valid inside the callback, copy them into the
+		receive buffer now */
+		bleEvent->value = rxExecuteWrite((CYBLE_GATTS_EXEC_WRITE_REQ_T *)eventParam);
+		break;
+
+	default:
+		/* Not handled by the bridge */
+		return;
+	}
+
+	bleCount++;
+	if (bleCount > eventStats.highWater)
+	{
+		eventStats.highWater = bleCount;
+	}
+}
+
+/*******************************************************************************
+ * Function Name: dispatchBleEvent
+ ********************************************************************************
+ * Summary:
+ *        This function handles a BLE stack event copied by AppCallBack()
+ *
+ * Parameters:
+ *  bleEvent:	event and its parameters
+ *
+ * Return:
+ *  void
+ *
+ *******************************************************************************/
+static void dispatchBleEvent(const BLE_EVENT_T *bleEvent)
+{
+	switch (bleEvent->event)
+	{
 	case CYBLE_EVT_STACK_ON:
 		/* start advertising */
-		apiResult = CyBle_GappStartAdvertisement(CYBLE_ADVERTISING_FAST);
+		startAdvertising();
+		break;
 
-		if (apiResult == CYBLE_ERROR_OK)
-		{
+	case CYBLE_EVT_GAPP_ADVERTISEMENT_START_STOP:
+		/* Fast advertising timed out, continue with the next phase */
+		handleAdvertisingStartStop();
+		break;
 
-#ifdef LED_INDICATION
-			ADV_LED_ON();
-#endif /* LED_INDICATION */
-		}
+	case CYBLE_EVT_STACK_BUSY_STATUS:
+		/* Queued notifications are sent from the main loop once the stack is free */
+		notifyStackBusy((uint8)bleEvent->value);
+		break;
+
+	case CYBLE_EVT_GATTS_XCNHG_MTU_REQ:
+		/* The BLE component responds with CYBLE_GATT_MTU, keep the negotiated size */
+		notifyMtuExchanged(bleEvent->value);
 		break;
 
 	case CYBLE_EVT_GAP_DEVICE_DISCONNECTED:
 
 		sendNotifications = 0;
+#ifdef STORE_AND_FORWARD
+		/* Queued frames are kept for the next connection */
+		notifyStackBusy(CYBLE_STACK_STATE_FREE);
+#else
+		clearNotificationQueue();
+#endif /* STORE_AND_FORWARD */
+		telemetryEnable(0u);
+#ifdef CREDIT_FLOW
+		notifyCreditReset();
+#endif /* CREDIT_FLOW */
+#ifdef HID_ENABLED
+		hidDisconnected();
+#endif /* HID_ENABLED */
+		notifyMtuExchanged(CYBLE_GATT_DEFAULT_MTU);
+
+#ifdef LINK_WARM_UP
+		linkDisconnected();
+#endif /* LINK_WARM_UP */
 
 #ifdef ENABLE_I2C_ONLY_WHEN_CONNECTED
 		/* Stop I2C Slave operation */
@@ -65,27 +259,58 @@ void AppCallBack(uint32 event, void *eventParam)
 #endif
 
 #ifdef LED_INDICATION
-		/* Indicate disconnect event to user */
-		DISCON_LED_ON();
-
-		CyDelay(3000);
+		/* Indicate disconnect event to user, advertising restarts meanwhile */
+		ledPlay(&ledPatternDisconnect);
 #endif /* LED_INDICATION */
 
 		/* start advertising */
-		apiResult = CyBle_GappStartAdvertisement(CYBLE_ADVERTISING_FAST);
+		bondDisconnected(bleEvent->time);
+		startAdvertising();
+		break;
+
+	case CYBLE_EVT_GAP_DEVICE_CONNECTED:
+		bondConnected();
+
+#ifdef LINK_WARM_UP
+		/* a new connection starts with the parameters chosen by the Central */
+		linkConnected(bleEvent->interval, bleEvent->latency);
+#endif /* LINK_WARM_UP */
+		break;
+
+	case CYBLE_EVT_GAP_AUTH_REQ:
+		/* The phone pairs, the next encryption is a new bond */
+		bondPairing();
+		break;
 
-		if (apiResult == CYBLE_ERROR_OK)
+	case CYBLE_EVT_GAP_ENCRYPT_CHANGE:
+		if (0u != bleEvent->value)
 		{
-#ifdef LED_INDICATION
-			ADV_LED_ON();
-#endif /* LED_INDICATION */
+			/* A bonded phone gets its notification setting back */
+			bondEncrypted();
+#ifdef HID_ENABLED
+			hidEncrypted();
+#endif /* HID_ENABLED */
 		}
 		break;
 
+#ifdef LINK_WARM_UP
+	case CYBLE_EVT_GAP_CONNECTION_UPDATE_COMPLETE:
+		if (0u == bleEvent->status)
+		{
+			linkUpdated(bleEvent->interval, bleEvent->latency);
+		}
+		break;
+
+	case CYBLE_EVT_L2CAP_CONN_PARAM_UPDATE_RSP:
+		linkUpdateResponse(bleEvent->value);
+		break;
+#endif /* LINK_WARM_UP */
+
 	case CYBLE_EVT_GATT_CONNECT_IND:
 
 #ifdef LED_INDICATION
-		CONNECT_LED_ON();
+		ledStop();
+		ledShow(LedConnected);
 #endif /* LED_INDICATION */
 
 #ifdef ENABLE_I2C_ONLY_WHEN_CONNECTED
@@ -93,26 +318,28 @@ void AppCallBack(uint32 event, void *eventParam)
 		I2C_Start();
 
 		/* Initialize I2C write buffer */
-		I2C_I2CSlaveInitWriteBuf((uint8 *)wrBuf, I2C_WRITE_BUFFER_SIZE);
+		initI2CWriteBuffer();
 
 		/* Initialize I2C read buffer */
-		I2C_I2CSlaveInitReadBuf((uint8 *)rdBuf, I2C_READ_BUFFER_SIZE);
+		I2C_I2CSlaveInitReadBuf(rdBuf, I2C_READ_BUFFER_SIZE);
 #endif
 		break;
 
 	/* Client may do Write Value or Write Value without Response. Handle both */
 	case CYBLE_EVT_GATTS_WRITE_REQ:
 	case CYBLE_EVT_GATTS_WRITE_CMD_REQ:
-		wrReqParam = (CYBLE_GATTS_WRITE_REQ_PARAM_T *)eventParam;
-
 		/* Handling Notification Enable */
-		if (wrReqParam->handleValPair.attrHandle == CYBLE_VOICE_ASSISTANT_LAUNCHER_TXCHARACTERISTIC_CLIENT_CHARACTERISTIC_CONFIGURATION_DESC_HANDLE)
+		if (bleEvent->value == CYBLE_VOICE_ASSISTANT_LAUNCHER_TXCHARACTERISTIC_CLIENT_CHARACTERISTIC_CONFIGURATION_DESC_HANDLE)
 		{
 			CYBLE_GATT_HANDLE_VALUE_PAIR_T I2CNotificationCCDHandle;
 			uint8 I2CCCDValue[2];
 
 			/* Extract CCCD Notification enable flag */
-			sendNotifications = wrReqParam->handleValPair.value.val[0];
+			sendNotifications = bleEvent->data[0];
+			if (0u != sendNotifications)
+			{
+				bondNotificationsEnabled();
+			}
 
 			/* Write the present I2C notification status to the local variable */
 			I2CCCDValue[0] = sendNotifications;
@@ -130,27 +357,50 @@ void AppCallBack(uint32 event, void *eventParam)
 			CyBle_GattsWriteAttributeValue(&I2CNotificationCCDHandle, 0, &cyBle_connHandle, CYBLE_GATT_DB_LOCALLY_INITIATED);
 		}
 
-		/* Handling Write data from Client */
-		else if (wrReqParam->handleValPair.attrHandle == CYBLE_VOICE_ASSISTANT_LAUNCHER_RXCHARACTERISTIC_CHAR_HANDLE)
-		// else if (wrReqParam->handleValPair.attrHandle == CYBLE_I2C_WRITE_I2C_WRITE_DATA_CHAR_HANDLE)
+#ifdef TELEMETRY_ENABLED
+		/* Handling Telemetry notification enable */
+		else if (bleEvent->value == CYBLE_VOICE_ASSISTANT_LAUNCHER_TELEMETRY_CLIENT_CHARACTERISTIC_CONFIGURATION_DESC_HANDLE)
 		{
-			/* Turn off I2C interrupt before updating read registers */
-			I2C_DisableInt();
+			CYBLE_GATT_HANDLE_VALUE_PAIR_T telemetryCCDHandle;
+			uint8 telemetryCCDValue[2];
+
+			telemetryEnable(bleEvent->data[0] & CYBLE_CCCD_NOTIFICATION);
+
+			telemetryCCDValue[0] = bleEvent->data[0] & CYBLE_CCCD_NOTIFICATION;
+			telemetryCCDValue[1] = 0x00;
+
+			telemetryCCDHandle.attrHandle = CYBLE_VOICE_ASSISTANT_LAUNCHER_TELEMETRY_CLIENT_CHARACTERISTIC_CONFIGURATION_DESC_HANDLE;
+			telemetryCCDHandle.value.val = telemetryCCDValue;
+			telemetryCCDHandle.value.len = 2;
+
+			CyBle_GattsWriteAttributeValue(&telemetryCCDHandle, 0, &cyBle_connHandle, CYBLE_GATT_DB_LOCALLY_INITIATED);
+		}
+#endif /* TELEMETRY_ENABLED */
 
-			/*The data received from I2C client is extracted */
-			for (i = 0; i < (wrReqParam->handleValPair.value.len); i++)
-				rdBuf[i] = wrReqParam->handleValPair.value.val[i];
+		/* Handling Write data from Client */
+		else if (bleEvent->value == CYBLE_VOICE_ASSISTANT_LAUNCHER_RXCHARACTERISTIC_CHAR_HANDLE)
+		{
+			/*The data received from I2C client is published to the I2C master */
+			rxWrite(bleEvent->data, bleEvent->len);
+		}
 
-			/* Turn on I2C interrupt after updating read registers */
-			I2C_EnableInt();
+		/* Handling blob chunks from Client */
+		else if (bleEvent->value == CYBLE_VOICE_ASSISTANT_LAUNCHER_RXSTREAM_CHAR_HANDLE)
+		{
+			rxStreamWrite(bleEvent->data, bleEvent->len);
 		}
 
-		if (event == CYBLE_EVT_GATTS_WRITE_REQ)
+		if (bleEvent->event == CYBLE_EVT_GATTS_WRITE_REQ)
 		{
 			CyBle_GattsWriteRsp(cyBle_connHandle);
 		}
 		break;
 
+	case CYBLE_EVT_GATTS_EXEC_WRITE_REQ:
+		/* Long write collected by AppCallBack(), hand it to the I2C master */
+		rxBlobReady(bleEvent->value);
+		break;
+
 	default:
 		break;
 	}
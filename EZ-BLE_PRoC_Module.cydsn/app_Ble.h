@@ -25,4 +25,6 @@ extern uint8 sendNotifications;
 // extern CYBLE_CONN_HANDLE_T ConnHandle;
 
 extern void AppCallBack(uint32, void *);
+extern uint8 bleEventPending(void);
+extern uint32 handleBleEvent(void);
 extern void SendNotification(uint8 *, uint8);
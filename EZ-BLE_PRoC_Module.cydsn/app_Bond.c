@@ -0,0 +1,368 @@
+/*
+ * Copyright (C) 2022 teamprof.net@gmail.com or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include "app_Bond.h"
+
+BOND_STATS_T bondStats;
+
+static uint8 advPhase;		/* ADV_PHASE_T of the running advertisement */
+static uint32 connectTime;	/* time stamp of the last connection */
+static uint8 readySeen;		/* notifications enabled since the connection */
+static uint8 notifySeen;	/* notification sent since the connection */
+static uint32 disconnectTime; /* time stamp of the last disconnect */
+static uint8 restartSeen = 1u; /* advertising restarted since the disconnect */
+static uint8 advBurst;		/* ADV_BURST_T */
+static uint8 pairingSeen;	/* the phone asked to pair on this connection */
+
+/*******************************************************************************
+ * Function Name: advertise
+ ********************************************************************************
+ * Summary:
+ *    This function starts the advertisement of the current phase
+ *
+ * Parameters:
+ *  void
+ *
+ * Return:
+ *  void
+ *
+ *******************************************************************************/
+static void advertise(void)
+{
+	uint8 intervalType = (AdvPhaseFast == advPhase) ? CYBLE_ADVERTISING_FAST : CYBLE_ADVERTISING_SLOW;
+
+	/* Any phone may connect, see ADV_PHASE_T */
+	cyBle_discoveryModeInfo.advParam->advFilterPolicy = CYBLE_GAPP_SCAN_ANY_CONN_ANY;
+
+	/* start advertising */
+	apiResult = CyBle_GappStartAdvertisement(intervalType);
+
+	if (apiResult == CYBLE_ERROR_OK)
+	{
+#ifdef LED_INDICATION
+		ledShow(LedAdvertising);
+#endif /* LED_INDICATION */
+	}
+}
+
+/*******************************************************************************
+ * Function Name: startAdvertising
+ ********************************************************************************
+ * Summary:
+ *    This function starts the advertising schedule, call on CYBLE_EVT_STACK_ON
+ *    and on disconnect
+ *
+ * Parameters:
+ *  void
+ *
+ * Return:
+ *  void
+ *
+ *******************************************************************************/
+void startAdvertising(void)
+{
+	advPhase = AdvPhaseFast;
+	advBurst = AdvBurstOff;
+	advertise();
+}
+
+/*******************************************************************************
+ * Function Name: handleAdvertisingStartStop
+ ********************************************************************************
+ * Summary:
+ *    This function records the first advertising start after a disconnect and
+ *    moves to the next advertising phase when the current one timed out, call
+ *    on CYBLE_EVT_GAPP_ADVERTISEMENT_START_STOP
+ *
+ * Parameters:
+ *  void
+ *
+ * Return:
+ *  void
+ *
+ *******************************************************************************/
+void handleAdvertisingStartStop(void)
+{
+	CYBLE_STATE_T state = CyBle_GetState();
+
+	if (CYBLE_STATE_ADVERTISING == state)
+	{
+		if (0u == restartSeen)
+		{
+			restartSeen = 1u;
+			bondStats.advRestartMs = appTimerElapsedMs(disconnectTime);
+			if (bondStats.advRestartMs > bondStats.advRestartMsMax)
+			{
+				bondStats.advRestartMsMax = bondStats.advRestartMs;
+			}
+		}
+		return;
+	}
+
+	/* Ignore the stop caused by a connection */
+	if (CYBLE_STATE_DISCONNECTED != state)
+	{
+		return;
+	}
+
+	if (AdvBurstStarting == advBurst)
+	{
+		/* The component keeps custom intervals, FAST and SLOW set their own again */
+		advBurst = AdvBurstOn;
+		cyBle_discoveryModeInfo.advParam->advIntvMin = ADV_BURST_INTERVAL;
+		cyBle_discoveryModeInfo.advParam->advIntvMax = ADV_BURST_INTERVAL;
+		cyBle_discoveryModeInfo.advTo = ADV_BURST_TIMEOUT;
+		(void)CyBle_GappStartAdvertisement(CYBLE_ADVERTISING_CUSTOM);
+		return;
+	}
+
+	if (AdvBurstOff != advBurst)
+	{
+		/* The interrupted phase starts over */
+		advBurst = AdvBurstOff;
+		advertise();
+		return;
+	}
+
+	if (AdvPhaseSlow == advPhase)
+	{
+		startAdvertising();
+		return;
+	}
+
+	advPhase = AdvPhaseSlow;
+	advertise();
+}
+
+/*******************************************************************************
+ * Function Name: advertisingBurst
+ ********************************************************************************
+ * Summary:
+ *    This function starts or ends a burst of fast advertising. The running
+ *    advertisement is stopped and handleAdvertisingStartStop() restarts it
+ *    with ADV_BURST_INTERVAL, ending the burst goes back to the schedule.
+ *    There is no burst while connected or between two phases.
+ *
+ * Parameters:
+ *  on:	1 to start a burst, 0 to end it
+ *
+ * Return:
+ *  uint8: 1 if the burst is starting or running
+ *
+ *******************************************************************************/
+uint8 advertisingBurst(uint8 on)
+{
+	if (CYBLE_STATE_ADVERTISING != CyBle_GetState())
+	{
+		return 0u;
+	}
+
+	if ((0u != on) && (AdvBurstOff == advBurst))
+	{
+		advBurst = AdvBurstStarting;
+		CyBle_GappStopAdvertisement();
+	}
+	else if ((0u == on) && (AdvBurstOn == advBurst))
+	{
+		advBurst = AdvBurstStopping;
+		CyBle_GappStopAdvertisement();
+	}
+	else if ((0u == on) && (AdvBurstStarting == advBurst))
+	{
+		/* The stop is on its way, go straight back to the schedule */
+		advBurst = AdvBurstStopping;
+	}
+	return (AdvBurstStarting == advBurst) || (AdvBurstOn == advBurst);
+}
+
+/*******************************************************************************
+ * Function Name: bondDisconnected
+ ********************************************************************************
+ * Summary:
+ *    This function starts timing the advertising restart, call on
+ *    CYBLE_EVT_GAP_DEVICE_DISCONNECTED
+ *
+ * Parameters:
+ *  time:	time stamp of the disconnect
+ *
+ * Return:
+ *  void
+ *
+ *******************************************************************************/
+void bondDisconnected(uint32 time)
+{
+	disconnectTime = time;
+	restartSeen = 0u;
+}
+
+/*******************************************************************************
+ * Function Name: bondConnected
+ ********************************************************************************
+ * Summary:
+ *    This function starts the reconnect timing and asks the phone to pair,
+ *    call on CYBLE_EVT_GAP_DEVICE_CONNECTED. A bonded phone encrypts the link
+ *    with the stored keys instead.
+ *
+ * Parameters:
+ *  void
+ *
+ * Return:
+ *  void
+ *
+ *******************************************************************************/
+void bondConnected(void)
+{
+	bondStats.connects++;
+	connectTime = appTimerNow();
+	advBurst = AdvBurstOff;
+	readySeen = 0u;
+	notifySeen = 0u;
+	pairingSeen = 0u;
+
+	(void)CyBle_GapAuthReq(cyBle_connHandle.bdHandle, &cyBle_authInfo);
+}
+
+/*******************************************************************************
+ * Function Name: bondPairing
+ ********************************************************************************
+ * Summary:
+ *    This function records that the phone pairs instead of using stored keys,
+ *    call on CYBLE_EVT_GAP_AUTH_REQ. A bonded phone answers the security
+ *    request with encryption and never sends a pairing request.
+ *
+ * Parameters:
+ *  void
+ *
+ * Return:
+ *  void
+ *
+ *******************************************************************************/
+void bondPairing(void)
+{
+	pairingSeen = 1u;
+}
+
+/*******************************************************************************
+ * Function Name: bondEncrypted
+ ********************************************************************************
+ * Summary:
+ *    This function is called when the link got encrypted. For a bonded phone
+ *    the BLE component restores the CCCD from flash, the notification flag is
+ *    taken from there so the phone does not have to enable notifications again.
+ *
+ * Parameters:
+ *  void
+ *
+ * Return:
+ *  void
+ *
+ *******************************************************************************/
+void bondEncrypted(void)
+{
+	CYBLE_GATT_HANDLE_VALUE_PAIR_T I2CNotificationCCDHandle;
+	uint8 I2CCCDValue[2];
+
+	/* The first encryption of a new bond is no reconnect */
+	if (0u == pairingSeen)
+	{
+		bondStats.bondedConnects++;
+	}
+
+	I2CNotificationCCDHandle.attrHandle = CYBLE_VOICE_ASSISTANT_LAUNCHER_TXCHARACTERISTIC_CLIENT_CHARACTERISTIC_CONFIGURATION_DESC_HANDLE;
+	I2CNotificationCCDHandle.value.val = I2CCCDValue;
+	I2CNotificationCCDHandle.value.len = sizeof(I2CCCDValue);
+
+	if ((CYBLE_GATT_ERR_NONE == CyBle_GattsReadAttributeValue(&I2CNotificationCCDHandle, &cyBle_connHandle, CYBLE_GATT_DB_LOCALLY_INITIATED)) &&
+		(0u != (I2CCCDValue[0] & CYBLE_CCCD_NOTIFICATION)))
+	{
+		sendNotifications = 1u;
+		bondNotificationsEnabled();
+	}
+}
+
+/*******************************************************************************
+ * Function Name: bondNotificationsEnabled
+ ********************************************************************************
+ * Summary:
+ *    This function records the time from connection to notifications enabled
+ *
+ * Parameters:
+ *  void
+ *
+ * Return:
+ *  void
+ *
+ *******************************************************************************/
+void bondNotificationsEnabled(void)
+{
+	if (0u == readySeen)
+	{
+		readySeen = 1u;
+		bondStats.readyMs = appTimerElapsedMs(connectTime);
+		if (bondStats.readyMs > bondStats.readyMsMax)
+		{
+			bondStats.readyMsMax = bondStats.readyMs;
+		}
+	}
+}
+
+/*******************************************************************************
+ * Function Name: bondNotified
+ ********************************************************************************
+ * Summary:
+ *    This function records the time from connection to the first notification
+ *
+ * Parameters:
+ *  void
+ *
+ * Return:
+ *  void
+ *
+ *******************************************************************************/
+void bondNotified(void)
+{
+	if (0u == notifySeen)
+	{
+		notifySeen = 1u;
+		bondStats.firstNotifyMs = appTimerElapsedMs(connectTime);
+	}
+}
+
+/*******************************************************************************
+ * Function Name: handleBonding
+ ********************************************************************************
+ * Summary:
+ *    This function writes pending bonding data (keys and CCCD) to flash, the
+ *    BLE component refuses the write while the radio is busy
+ *
+ * Parameters:
+ *  void
+ *
+ * Return:
+ *  void
+ *
+ *******************************************************************************/
+void handleBonding(void)
+{
+	if (0u != cyBle_pendingFlashWrite)
+	{
+		(void)CyBle_StoreBondingData(0u);
+	}
+}
@@ -0,0 +1,74 @@
+/*
+ * Copyright (C) 2022 teamprof.net@gmail.com or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#pragma once
+#include "main.h"
+
+/* Advertising schedule after power up or a disconnect: a fast phase, then a
+   slow phase, then over again. Advertising is always open (no white list).
+   Phones connect from resolvable private addresses and this controller
+   does not resolve them, a white list of bonded addresses would keep the
+   bonded phone out. A bonded phone is recognized when it encrypts the link
+   with the stored keys: the BLE component bonds (Security tab: bonding,
+   Just Works with encryption) and keeps keys and CCCD in flash, the phone
+   skips pairing and enabling notifications on a reconnect. Interval and
+   timeout of the phases are set in the BLE component customizer. */
+typedef enum
+{
+	AdvPhaseFast,
+	AdvPhaseSlow
+} ADV_PHASE_T;
+
+/* A burst interrupts the schedule with a short stretch of fast advertising,
+   see advertisingBurst() */
+typedef enum
+{
+	AdvBurstOff,
+	AdvBurstStarting, /* waiting for the schedule to stop */
+	AdvBurstOn,
+	AdvBurstStopping  /* waiting for the burst to stop */
+} ADV_BURST_T;
+
+#define ADV_BURST_INTERVAL 0x20u /* 20 ms in 0.625 ms units, fastest for connectable advertising */
+#define ADV_BURST_TIMEOUT 1u	 /* s, stops a burst that was never ended */
+
+typedef struct
+{
+	uint32 connects;	   /* connections */
+	uint32 bondedConnects; /* connections encrypted with stored keys, pairing not counted */
+	uint32 readyMs;		   /* connect to notifications enabled, last connection */
+	uint32 readyMsMax;	   /* worst connect to notifications enabled */
+	uint32 firstNotifyMs;  /* connect to first notification, last connection */
+	uint32 advRestartMs;   /* disconnect to advertising, last disconnect */
+	uint32 advRestartMsMax; /* worst disconnect to advertising */
+} BOND_STATS_T;
+
+extern BOND_STATS_T bondStats;
+
+extern void startAdvertising(void);
+extern void handleAdvertisingStartStop(void);
+extern uint8 advertisingBurst(uint8 on);
+extern void bondDisconnected(uint32 time);
+extern void bondConnected(void);
+extern void bondPairing(void);
+extern void bondEncrypted(void);
+extern void bondNotificationsEnabled(void);
+extern void bondNotified(void);
+extern void handleBonding(void);
@@ -0,0 +1,269 @@
+/*
+ * Copyright (C) 2022 teamprof.net@gmail.com or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include <string.h>
+#include "app_Broadcast.h"
+
+#ifdef ADV_BROADCAST
+#define XTEA_ROUNDS 32u
+#define XTEA_DELTA 0x9E3779B9u
+
+BROADCAST_STATS_T broadcastStats;
+
+static BROADCAST_PROVISION_T provision; /* key and company id of this device */
+static uint8 provisioned;				/* provision holds a valid key */
+static uint8 baseLen = 0xFFu;	/* advertising data without the record, 0xFF before the first message */
+static uint16 sequence;			/* of the last message */
+static uint8 messageLive;		/* record is in the advertising data */
+static uint32 messageTime;		/* time stamp of the last message */
+static uint8 burstLive;			/* burst requested */
+static uint32 burstTime;		/* time stamp of the last burst */
+static uint32 windowTime;		/* start of the duty cycle window */
+static uint8 windowBursts;		/* bursts in the duty cycle window */
+
+/*******************************************************************************
+ * Function Name: xteaEncipher
+ ********************************************************************************
+ * Summary:
+ *    This function encrypts one 64-bit block with the provisioned key
+ *
+ * Parameters:
+ *  v:	block, replaced by the cipher text
+ *
+ * Return:
+ *  void
+ *
+ *******************************************************************************/
+static void xteaEncipher(uint32 v[2])
+{
+	uint32 v0 = v[0];
+	uint32 v1 = v[1];
+	uint32 sum = 0u;
+	uint8 i;
+
+	for (i = 0; i < XTEA_ROUNDS; i++)
+	{
+		v0 += (((v1 << 4) ^ (v1 >> 5)) + v1) ^ (sum + provision.key[sum & 3u]);
+		sum += XTEA_DELTA;
+		v1 += (((v0 << 4) ^ (v0 >> 5)) + v0) ^ (sum + provision.key[(sum >> 11) & 3u]);
+	}
+	v[0] = v0;
+	v[1] = v1;
+}
+
+/*******************************************************************************
+ * Function Name: broadcastTag
+ ********************************************************************************
+ * Summary:
+ *    This function computes the tag of a record, an XTEA CBC-MAC truncated to
+ *    BROADCAST_TAG_SIZE bytes
+ *
+ * Parameters:
+ *  data:	record without the tag
+ *  len:	number of bytes
+ *  tag:	returns BROADCAST_TAG_SIZE bytes
+ *
+ * Return:
+ *  void
+ *
+ *******************************************************************************/
+static void broadcastTag(const uint8 *data, uint8 len, uint8 *tag)
+{
+	uint32 v[2] = {0u, 0u};
+	uint8 i;
+
+	for (i = 0; i < len; i++)
+	{
+		v[(i & 7u) >> 2] ^= (uint32)data[i] << (8u * (i & 3u));
+		if ((7u == (i & 7u)) || ((i + 1u) == len))
+		{
+			xteaEncipher(v);
+		}
+	}
+
+	for (i = 0; i < BROADCAST_TAG_SIZE; i++)
+	{
+		tag[i] = (uint8)(v[0] >> (8u * i));
+	}
+}
+
+/*******************************************************************************
+ * Function Name: updateAdvertisingData
+ ********************************************************************************
+ * Summary:
+ *    This function sets the length of the advertising data, the record is
+ *    kept behind the data of the BLE component customizer
+ *
+ * Parameters:
+ *  len:	advertising data length
+ *
+ * Return:
+ *  void
+ *
+ *******************************************************************************/
+static void updateAdvertisingData(uint8 len)
+{
+	cyBle_discoveryModeInfo.advData->advDataLen = len;
+
+	/* A stopped advertisement picks the data up when it starts */
+	if (CYBLE_STATE_ADVERTISING == CyBle_GetState())
+	{
+		(void)CyBle_GapUpdateAdvData(cyBle_discoveryModeInfo.advData, cyBle_discoveryModeInfo.scanRspData);
+	}
+}
+
+/*******************************************************************************
+ * Function Name: broadcastInit
+ ********************************************************************************
+ * Summary:
+ *    This function loads the key and the company id from the provisioning
+ *    row of the user SFlash. Broadcasting stays disabled when the row is not
+ *    provisioned.
+ *
+ * Parameters:
+ *  void
+ *
+ * Return:
+ *  void
+ *
+ *******************************************************************************/
+void broadcastInit(void)
+{
+	memcpy(&provision, (const void *)(CY_SFLASH_USERBASE + (BROADCAST_PROVISION_ROW * CY_SFLASH_SIZEOF_USERROW)), sizeof(provision));
+
+	provisioned = (BROADCAST_PROVISION_MAGIC == provision.magic) &&
+				  (0u != (provision.key[0] | provision.key[1] | provision.key[2] | provision.key[3]));
+	if (0u == provisioned)
+	{
+		memset(&provision, 0, sizeof(provision));
+	}
+}
+
+/*******************************************************************************
+ * Function Name: broadcastFrame
+ ********************************************************************************
+ * Summary:
+ *    This function puts a launcher message written by the I2C master in the
+ *    advertising data and asks for a burst of fast advertising, as long as
+ *    the duty cycle allows it. Other frames, all frames while connected and
+ *    all frames of a device without a provisioned key are left to the
+ *    notifications.
+ *
+ * Parameters:
+ *  frame:	frame written by the I2C master
+ *  len:	number of bytes
+ *
+ * Return:
+ *  void
+ *
+ *******************************************************************************/
+void broadcastFrame(const uint8 *frame, uint8 len)
+{
+	uint8 *record;
+
+	if ((IPC_MESSAGE_SIZE != len) || (CYBLE_STATE_CONNECTED == cyBle_state))
+	{
+		return;
+	}
+	if (0u == provisioned)
+	{
+		broadcastStats.locked++;
+		return;
+	}
+
+	if (0xFFu == baseLen)
+	{
+		baseLen = cyBle_discoveryModeInfo.advData->advDataLen;
+	}
+	if ((baseLen + BROADCAST_RECORD_SIZE) > CYBLE_GAP_MAX_ADV_DATA_LEN)
+	{
+		/* Shorten the device name in the BLE component customizer */
+		broadcastStats.dropped++;
+		return;
+	}
+
+	sequence++;
+	record = &cyBle_discoveryModeInfo.advData->advData[baseLen];
+	record[0] = BROADCAST_RECORD_SIZE - 1u;
+	record[1] = BROADCAST_AD_TYPE;
+	record[2] = LO8(provision.companyId);
+	record[3] = HI8(provision.companyId);
+	record[4] = BROADCAST_VERSION;
+	record[5] = LO8(sequence);
+	record[6] = HI8(sequence);
+	memcpy(&record[7], frame, IPC_MESSAGE_SIZE);
+	broadcastTag(record, BROADCAST_RECORD_SIZE - BROADCAST_TAG_SIZE, &record[BROADCAST_RECORD_SIZE - BROADCAST_TAG_SIZE]);
+
+	updateAdvertisingData(baseLen + BROADCAST_RECORD_SIZE);
+	messageLive = 1u;
+	messageTime = appTimerNow();
+	broadcastStats.messages++;
+
+	if (appTimerElapsed(windowTime) >= APP_TIMER_MS(BROADCAST_WINDOW_MS))
+	{
+		windowTime = messageTime;
+		windowBursts = 0u;
+	}
+	if (windowBursts >= BROADCAST_BURSTS_PER_WINDOW)
+	{
+		/* Still advertised, at the interval of the current phase */
+		broadcastStats.throttled++;
+		return;
+	}
+
+	if (0u != advertisingBurst(1u))
+	{
+		windowBursts++;
+		broadcastStats.bursts++;
+		burstLive = 1u;
+		burstTime = messageTime;
+	}
+}
+
+/*******************************************************************************
+ * Function Name: handleBroadcast
+ ********************************************************************************
+ * Summary:
+ *    This function ends the burst after BROADCAST_BURST_MS and withdraws the
+ *    message after BROADCAST_AGE_MS, so a phone that starts scanning later
+ *    does not act on it
+ *
+ * Parameters:
+ *  void
+ *
+ * Return:
+ *  void
+ *
+ *******************************************************************************/
+void handleBroadcast(void)
+{
+	if ((0u != burstLive) && (appTimerElapsed(burstTime) >= APP_TIMER_MS(BROADCAST_BURST_MS)))
+	{
+		burstLive = 0u;
+		(void)advertisingBurst(0u);
+	}
+
+	if ((0u != messageLive) && (appTimerElapsed(messageTime) >= APP_TIMER_MS(BROADCAST_AGE_MS)))
+	{
+		messageLive = 0u;
+		updateAdvertisingData(baseLen);
+	}
+}
+#endif /* ADV_BROADCAST */
@@ -0,0 +1,69 @@
+/*
+ * Copyright (C) 2022 teamprof.net@gmail.com or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#pragma once
+#include "main.h"
+
+/* While no phone is connected, launcher messages are also broadcast in the
+   advertising data, so a phone that is scanning can act without connecting.
+   Manufacturer Specific Data record, multi-byte fields little endian:
+     [length][0xFF][company id:2][version][sequence:2][message:4][tag:4]
+   The tag is the first half of an XTEA CBC-MAC with the device key over
+   [length][0xFF][company id][version][sequence][message], zero padded to
+   8 bytes. The sequence is the same for all repeats of one message. */
+#define BROADCAST_VERSION 1u
+#define BROADCAST_AD_TYPE 0xFFu		 /* Manufacturer Specific Data */
+#define BROADCAST_TAG_SIZE 4u
+#define BROADCAST_RECORD_SIZE (2u + 2u + 1u + 2u + IPC_MESSAGE_SIZE + BROADCAST_TAG_SIZE)
+
+/* The key and the company id are provisioned per device in a user SFlash
+   row, written at production together with the phone app pairing data.
+   Row 0 is left to the BLE component for the device address. A device
+   without a valid row never broadcasts. */
+#define BROADCAST_PROVISION_ROW 1u
+#define BROADCAST_PROVISION_MAGIC 0x59454B42u /* "BKEY" */
+
+typedef struct
+{
+	uint32 magic;	  /* BROADCAST_PROVISION_MAGIC */
+	uint16 companyId; /* Bluetooth SIG company id, 0xFFFF is reserved for tests */
+	uint16 reserved;
+	uint32 key[4];	  /* XTEA key, not all zero */
+} BROADCAST_PROVISION_T;
+
+#define BROADCAST_BURST_MS 250u			 /* fast advertising after a message */
+#define BROADCAST_WINDOW_MS 10000u		 /* duty cycle window */
+#define BROADCAST_BURSTS_PER_WINDOW 5u	 /* limits fast advertising to 12.5 % of the time */
+#define BROADCAST_AGE_MS 5000u			 /* a message is withdrawn after this */
+
+typedef struct
+{
+	uint32 messages;  /* messages put in the advertising data */
+	uint32 bursts;	  /* fast advertising bursts */
+	uint32 throttled; /* messages sent without a burst, duty cycle used up */
+	uint32 dropped;	  /* messages that did not fit in the advertising data */
+	uint32 locked;	  /* messages not broadcast, no key provisioned */
+} BROADCAST_STATS_T;
+
+extern BROADCAST_STATS_T broadcastStats;
+
+extern void broadcastInit(void);
+extern void broadcastFrame(const uint8 *frame, uint8 len);
+extern void handleBroadcast(void);
@@ -0,0 +1,153 @@
+/*
+ * Copyright (C) 2022 teamprof.net@gmail.com or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include "app_Event.h"
+
+APP_EVENT_STATS_T eventStats;
+
+static volatile uint8 i2cEvents; /* APP_EVENT_T flags posted by the I2C interrupt */
+
+/*******************************************************************************
+ * Function Name: recordTiming
+ ********************************************************************************
+ * Summary:
+ *    This function adds the handler time of an event to its timing slot
+ *
+ * Parameters:
+ *  event:	APP_EVENT_CODE() or CYBLE_EVT_xxx
+ *  ticks:	handler time (APP_TIMER_HZ)
+ *
+ * Return:
+ *  void
+ *
+ *******************************************************************************/
+static void recordTiming(uint32 event, uint32 ticks)
+{
+	APP_EVENT_TIMING_T *timing;
+	uint8 i;
+
+	for (i = 0; i < APP_EVENT_TIMING_SLOTS; i++)
+	{
+		timing = &eventStats.timing[i];
+		if ((timing->event == event) || (0u == timing->count))
+		{
+			timing->event = event;
+			timing->count++;
+			timing->ticks += ticks;
+			if (ticks > timing->maxTicks)
+			{
+				timing->maxTicks = ticks;
+			}
+			return;
+		}
+	}
+}
+
+/*******************************************************************************
+ * Function Name: postEvent
+ ********************************************************************************
+ * Summary:
+ *    This function posts an event for the main loop, it can be called from an
+ *    interrupt
+ *
+ * Parameters:
+ *  event:	APP_EVENT_T
+ *
+ * Return:
+ *  void
+ *
+ *******************************************************************************/
+void postEvent(uint8 event)
+{
+	uint8 interruptStatus = CyEnterCriticalSection();
+
+	i2cEvents |= (uint8)(1u << event);
+
+	CyExitCriticalSection(interruptStatus);
+}
+
+/*******************************************************************************
+ * Function Name: eventPending
+ ********************************************************************************
+ * Summary:
+ *    This function tells whether events wait for the main loop, the low power
+ *    mode must not be entered while it returns non-zero
+ *
+ * Parameters:
+ *  void
+ *
+ * Return:
+ *  uint8: non-zero if events are pending
+ *
+ *******************************************************************************/
+uint8 eventPending(void)
+{
+	return (0u != i2cEvents) || (0u != bleEventPending());
+}
+
+/*******************************************************************************
+ * Function Name: handleEvents
+ ********************************************************************************
+ * Summary:
+ *    This function handles the posted events. I2C completions go first, they
+ *    free write buffers for the launcher, BLE events follow in the order the
+ *    stack reported them. The time of every handler is recorded.
+ *
+ * Parameters:
+ *  void
+ *
+ * Return:
+ *  void
+ *
+ *******************************************************************************/
+void handleEvents(void)
+{
+	uint8 interruptStatus;
+	uint8 events;
+	uint32 event;
+	uint32 start;
+
+	for (;;)
+	{
+		interruptStatus = CyEnterCriticalSection();
+		events = i2cEvents;
+		i2cEvents = 0u;
+		CyExitCriticalSection(interruptStatus);
+
+		if (0u != events)
+		{
+			/* Both completions are taken from the I2C slave status */
+			start = appTimerNow();
+			handleI2CTraffic();
+			recordTiming(APP_EVENT_CODE((0u != (events & (1u << AppEventI2CWrite))) ? AppEventI2CWrite : AppEventI2CRead),
+						 appTimerElapsed(start));
+		}
+		else if (0u != bleEventPending())
+		{
+			start = appTimerNow();
+			event = handleBleEvent();
+			recordTiming(event, appTimerElapsed(start));
+		}
+		else
+		{
+			break;
+		}
+	}
+}
@@ -0,0 +1,62 @@
+/*
+ * Copyright (C) 2022 teamprof.net@gmail.com or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#pragma once
+#include "main.h"
+
+/* BLE events waiting for the main loop, see app_Ble.c. handleEvents() empties
+   the queue before the next CyBle_ProcessEvents() call, so it has to hold what
+   a single call reports: a connection event full of writes without response
+   plus the link state events around it. */
+#define APP_EVENT_QUEUE_DEPTH 16u
+#define APP_EVENT_TIMING_SLOTS 16u /* event codes with handler timing */
+
+/* Events posted by the I2C interrupt. They only carry a flag, the transfer
+   state is taken from the I2C slave status, so they are never lost. */
+typedef enum
+{
+	AppEventNone,
+	AppEventI2CWrite, /* I2C master completed a write */
+	AppEventI2CRead   /* I2C master completed a read */
+} APP_EVENT_T;
+
+/* Timing code of an APP_EVENT_T, BLE events use their CYBLE_EVT_xxx code */
+#define APP_EVENT_CODE(event) (0x80000000u | (uint32)(event))
+
+typedef struct
+{
+	uint32 event;	 /* APP_EVENT_CODE() or CYBLE_EVT_xxx */
+	uint32 count;	 /* times handled */
+	uint32 ticks;	 /* total handler time (APP_TIMER_HZ) */
+	uint32 maxTicks; /* longest handler time (APP_TIMER_HZ) */
+} APP_EVENT_TIMING_T;
+
+typedef struct
+{
+	APP_EVENT_TIMING_T timing[APP_EVENT_TIMING_SLOTS];
+	uint32 overflow; /* BLE events dropped, the queue was full */
+	uint8 highWater; /* largest BLE event queue depth seen */
+} APP_EVENT_STATS_T;
+
+extern APP_EVENT_STATS_T eventStats;
+
+extern void postEvent(uint8 event);
+extern uint8 eventPending(void);
+extern void handleEvents(void);
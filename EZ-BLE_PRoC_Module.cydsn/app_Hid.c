@@ -0,0 +1,314 @@
+/*
+ * Copyright (C) 2022 teamprof.net@gmail.com or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include "app_Hid.h"
+
+#ifdef HID_ENABLED
+typedef struct
+{
+	uint16 event; /* launcher IPC event */
+	uint16 param; /* launcher IPC parameter */
+	uint16 usage; /* consumer control usage */
+} HID_KEY_MAP_T;
+
+/* Launcher messages the phone OS handles itself */
+static const HID_KEY_MAP_T hidKeyMap[] =
+{
+	{IPC_EVENT_LAUNCH_APP, IPC_APP_VOICE_ASSISTANT, HID_USAGE_VOICE_COMMAND},
+};
+
+HID_STATS_T hidStats;
+
+static uint8 hidNotify;					 /* Host enabled the consumer report */
+static uint16 hidKeys[HID_QUEUE_DEPTH];	 /* usages waiting to be pressed */
+static uint8 hidHead;					 /* oldest key */
+static uint8 hidCount;					 /* number of keys */
+static uint8 hidReleasePending;			 /* key pressed, release not sent yet */
+static uint8 hidTokens = HID_KEY_BURST;	 /* key presses left in the budget */
+static uint32 hidTokenTime;				 /* time stamp of the last token */
+
+/*******************************************************************************
+ * Function Name: HidsCallBack
+ ********************************************************************************
+ * Summary:
+ *    This function records the CCCD of the consumer report, it is called by
+ *    the BLE component from CyBle_ProcessEvents()
+ *
+ * Parameters:
+ *  event:	HID Service event
+ *  eventParam:	CYBLE_HIDS_CHAR_VALUE_T of the characteristic
+ *
+ * Return:
+ *  void
+ *
+ *******************************************************************************/
+static void HidsCallBack(uint32 event, void *eventParam)
+{
+	CYBLE_HIDS_CHAR_VALUE_T *charValue = (CYBLE_HIDS_CHAR_VALUE_T *)eventParam;
+
+	if (HID_CONSUMER_REPORT != charValue->charIndex)
+	{
+		return;
+	}
+
+	switch (event)
+	{
+	case CYBLE_EVT_HIDSS_NOTIFICATION_ENABLED:
+		hidNotify = 1u;
+		break;
+
+	case CYBLE_EVT_HIDSS_NOTIFICATION_DISABLED:
+		hidNotify = 0u;
+		break;
+
+	default:
+		break;
+	}
+}
+
+/*******************************************************************************
+ * Function Name: sendReport
+ ********************************************************************************
+ * Summary:
+ *    This function notifies the consumer report
+ *
+ * Parameters:
+ *  usage:	key pressed, HID_USAGE_NONE for the release
+ *
+ * Return:
+ *  uint8: 0 if the stack has no buffer, the report must be sent again
+ *
+ *******************************************************************************/
+static uint8 sendReport(uint16 usage)
+{
+	uint8 report[HID_REPORT_SIZE];
+
+	report[0] = LO8(usage);
+	report[1] = HI8(usage);
+
+	apiResult = CyBle_HidssSendNotification(cyBle_connHandle, HID_SERVICE_INDEX, HID_CONSUMER_REPORT, HID_REPORT_SIZE, report);
+	if ((CYBLE_ERROR_MEMORY_ALLOCATION_FAILED == apiResult) || (CYBLE_ERROR_INSUFFICIENT_RESOURCES == apiResult))
+	{
+		hidStats.retries++;
+		return 0u;
+	}
+
+	if (CYBLE_ERROR_OK == apiResult)
+	{
+		hidStats.reports++;
+	}
+	return 1u;
+}
+
+/*******************************************************************************
+ * Function Name: refillBudget
+ ********************************************************************************
+ * Summary:
+ *    This function adds the key presses earned since the last call to the
+ *    budget, up to HID_KEY_BURST
+ *
+ * Parameters:
+ *  void
+ *
+ * Return:
+ *  void
+ *
+ *******************************************************************************/
+static void refillBudget(void)
+{
+	while ((hidTokens < HID_KEY_BURST) && (appTimerElapsed(hidTokenTime) >= APP_TIMER_MS(HID_KEY_INTERVAL_MS)))
+	{
+		hidTokens++;
+		hidTokenTime += APP_TIMER_MS(HID_KEY_INTERVAL_MS);
+	}
+
+	if (hidTokens >= HID_KEY_BURST)
+	{
+		/* A full budget does not save up more */
+		hidTokenTime = appTimerNow();
+	}
+}
+
+/*******************************************************************************
+ * Function Name: hidInit
+ ********************************************************************************
+ * Summary:
+ *    This function registers the HID Service callback, call after CyBle_Start()
+ *
+ * Parameters:
+ *  void
+ *
+ * Return:
+ *  void
+ *
+ *******************************************************************************/
+void hidInit(void)
+{
+	CyBle_HidsRegisterAttrCallback(HidsCallBack);
+	hidTokenTime = appTimerNow();
+}
+
+/*******************************************************************************
+ * Function Name: hidFrame
+ ********************************************************************************
+ * Summary:
+ *    This function queues the key press of a launcher message written by the
+ *    I2C master. Messages without a key in hidKeyMap and messages over the
+ *    report budget are left to the custom characteristics.
+ *
+ * Parameters:
+ *  frame:	frame written by the I2C master
+ *  len:	number of bytes
+ *
+ * Return:
+ *  void
+ *
+ *******************************************************************************/
+void hidFrame(const uint8 *frame, uint8 len)
+{
+	uint16 event;
+	uint16 param;
+	uint8 i;
+
+	if ((IPC_MESSAGE_SIZE != len) || (0u == hidNotify) || (CYBLE_STATE_CONNECTED != cyBle_state))
+	{
+		return;
+	}
+
+	event = (uint16)(frame[0] | ((uint16)frame[1] << 8));
+	param = (uint16)(frame[2] | ((uint16)frame[3] << 8));
+
+	for (i = 0; i < (sizeof(hidKeyMap) / sizeof(hidKeyMap[0])); i++)
+	{
+		if ((hidKeyMap[i].event == event) && (hidKeyMap[i].param == param))
+		{
+			break;
+		}
+	}
+	if (i == (sizeof(hidKeyMap) / sizeof(hidKeyMap[0])))
+	{
+		return;
+	}
+
+	refillBudget();
+	if (0u == hidTokens)
+	{
+		hidStats.throttled++;
+		return;
+	}
+
+	if (hidCount >= HID_QUEUE_DEPTH)
+	{
+		hidStats.dropped++;
+		return;
+	}
+
+	hidTokens--;
+	hidKeys[(hidHead + hidCount) % HID_QUEUE_DEPTH] = hidKeyMap[i].usage;
+	hidCount++;
+	hidStats.keys++;
+}
+
+/*******************************************************************************
+ * Function Name: hidEncrypted
+ ********************************************************************************
+ * Summary:
+ *    This function takes the consumer report CCCD restored from the bond, call
+ *    when the link got encrypted
+ *
+ * Parameters:
+ *  void
+ *
+ * Return:
+ *  void
+ *
+ *******************************************************************************/
+void hidEncrypted(void)
+{
+	uint8 cccd[2];
+
+	if (CYBLE_ERROR_OK == CyBle_HidssGetCharacteristicDescriptor(HID_SERVICE_INDEX, HID_CONSUMER_REPORT, CYBLE_HIDS_REPORT_CCCD, sizeof(cccd), cccd))
+	{
+		hidNotify = cccd[0] & CYBLE_CCCD_NOTIFICATION;
+	}
+}
+
+/*******************************************************************************
+ * Function Name: hidDisconnected
+ ********************************************************************************
+ * Summary:
+ *    This function drops the queued key presses, call on
+ *    CYBLE_EVT_GAP_DEVICE_DISCONNECTED
+ *
+ * Parameters:
+ *  void
+ *
+ * Return:
+ *  void
+ *
+ *******************************************************************************/
+void hidDisconnected(void)
+{
+	hidStats.dropped += hidCount;
+	hidCount = 0u;
+	hidReleasePending = 0u;
+	hidNotify = 0u;
+}
+
+/*******************************************************************************
+ * Function Name: handleHid
+ ********************************************************************************
+ * Summary:
+ *    This function sends the queued key presses, each one as a press and a
+ *    release report. It returns as soon as the stack has no buffer, the
+ *    report is sent again on the next call.
+ *
+ * Parameters:
+ *  void
+ *
+ * Return:
+ *  void
+ *
+ *******************************************************************************/
+void handleHid(void)
+{
+	while ((0u != hidReleasePending) || (0u != hidCount))
+	{
+		if (0u != hidReleasePending)
+		{
+			if (0u == sendReport(HID_USAGE_NONE))
+			{
+				break;
+			}
+			hidReleasePending = 0u;
+		}
+		else
+		{
+			if (0u == sendReport(hidKeys[hidHead]))
+			{
+				break;
+			}
+			hidHead = (hidHead + 1u) % HID_QUEUE_DEPTH;
+			hidCount--;
+			hidReleasePending = 1u;
+		}
+	}
+}
+#endif /* HID_ENABLED */
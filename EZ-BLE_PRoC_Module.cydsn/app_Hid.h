@@ -0,0 +1,77 @@
+/*
+ * Copyright (C) 2022 teamprof.net@gmail.com or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#pragma once
+#include "main.h"
+
+/* The Human Interface Device service of the BLE component has Protocol Mode,
+   HID Information, HID Control Point and one Input Report characteristic
+   (Report Consumer) for consumer control, with this Report Map:
+     05 0C        Usage Page (Consumer)
+     09 01        Usage (Consumer Control)
+     A1 01        Collection (Application)
+     15 00        Logical Minimum (0)
+     26 FF 03     Logical Maximum (1023)
+     19 00        Usage Minimum (0)
+     2A FF 03     Usage Maximum (1023)
+     75 10        Report Size (16)
+     95 01        Report Count (1)
+     81 00        Input (Data, Array, Absolute)
+     C0           End Collection
+   HID over GATT needs an encrypted link, the phone pairs and bonds. */
+#ifdef CYBLE_HIDS_SERVER
+#define HID_ENABLED
+#endif
+
+/* Names generated for the service and its report */
+#define HID_SERVICE_INDEX CYBLE_HUMAN_INTERFACE_DEVICE_SERVICE_INDEX
+#define HID_CONSUMER_REPORT CYBLE_HUMAN_INTERFACE_DEVICE_REPORT_CONSUMER
+#define HID_REPORT_SIZE 2u
+
+/* Consumer Page usages */
+#define HID_USAGE_NONE 0x0000u
+#define HID_USAGE_SCAN_NEXT 0x00B5u
+#define HID_USAGE_SCAN_PREVIOUS 0x00B6u
+#define HID_USAGE_PLAY_PAUSE 0x00CDu
+#define HID_USAGE_VOICE_COMMAND 0x00CFu
+#define HID_USAGE_MUTE 0x00E2u
+#define HID_USAGE_VOLUME_UP 0x00E9u
+#define HID_USAGE_VOLUME_DOWN 0x00EAu
+
+#define HID_QUEUE_DEPTH 4u		  /* key presses waiting for the stack */
+#define HID_KEY_INTERVAL_MS 250u  /* one key press is earned every interval */
+#define HID_KEY_BURST 2u		  /* key presses that can be saved up */
+
+typedef struct
+{
+	uint32 keys;	  /* key presses queued */
+	uint32 reports;	  /* reports accepted by the stack, press and release */
+	uint32 retries;	  /* report refused for lack of stack buffers */
+	uint32 throttled; /* key presses over the report budget */
+	uint32 dropped;	  /* key presses lost to a full queue or a disconnect */
+} HID_STATS_T;
+
+extern HID_STATS_T hidStats;
+
+extern void hidInit(void);
+extern void hidFrame(const uint8 *frame, uint8 len);
+extern void hidEncrypted(void);
+extern void hidDisconnected(void);
+extern void handleHid(void);
@@ -18,15 +18,49 @@
  * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
  * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
  */
+#include <string.h>
 #include "app_I2C.h"
 
 static uint32 byteCnt; /* variable to store the number of bytes written by I2C mater */
+static uint8 *frame;   /* write buffer holding the frame being handled */
+static uint8 frameSlot; /* notification slot of frame */
+static uint32 frameTime; /* completion time stamp of frame */
+
+/* Writes completed by the I2C interrupt, taken by handleI2CTraffic(). Every
+   waiting write holds a frame slot, so the ring has an entry for each slot
+   and only the slot pool limits a burst. */
+typedef struct
+{
+	uint32 time; /* completion time stamp */
+	uint8 slot;	 /* notification slot holding the frame */
+	uint8 len;	 /* number of bytes */
+} I2C_WRITE_T;
+
+static I2C_WRITE_T i2cWrites[NTF_SLOT_COUNT];
+static uint8 i2cWriteHead;
+static volatile uint8 i2cWriteCount;
+static uint8 wrSlot = NTF_SLOT_NONE; /* notification slot of wrBuf */
+
+I2C_STATS_T i2cStats;
+
+static uint8 rdBufs[2][I2C_READ_BUFFER_SIZE]; /* published and next read buffer */
+static uint8 *rdNext = rdBufs[1];			   /* filled by the Client, published when the I2C bus is idle */
+static volatile uint8 rdPending;			   /* rdNext waits for a master read to finish */
+uint8 *rdBuf = rdBufs[0];					   /* I2C read buffer, seen by the master */
+static volatile uint8 rdUnread;				   /* rdBuf was not read since it was published */
+static volatile uint8 rdTaken;				   /* the master read rdBuf, set by the I2C interrupt */
+
+static I2C_REG_FILE_T regFile = {.version = I2C_REG_VERSION, .size = sizeof(I2C_REG_FILE_T)};
+static volatile uint8 regSelected; /* next read returns regFile, set by the I2C interrupt */
+static uint8 regLastError;		   /* last BLE API result other than CYBLE_ERROR_OK */
 
 /*******************************************************************************
- * Function Name: handleI2CTraffic
+ * Function Name: publishReadBuffer
  ********************************************************************************
  * Summary:
- *    This function handles the I2C read or write processing
+ *    This function hands rdNext to the I2C slave and keeps the old read buffer
+ *    for the next update. Call with the I2C interrupt disabled and no master
+ *    read in progress.
  *
  * Parameters:
  *  void
@@ -35,40 +69,354 @@ static uint32 byteCnt; /* variable to store the number of bytes written by I2C m
  *  void
  *
  *******************************************************************************/
-void handleI2CTraffic(void)
+static void publishReadBuffer(void)
+{
+	uint8 *published = rdNext;
+
+	rdNext = rdBuf;
+	rdBuf = published;
+	I2C_I2CSlaveInitReadBuf(rdBuf, I2C_READ_BUFFER_SIZE);
+	rdPending = 0u;
+
+	/* Tell the launcher there is something to read */
+	rdUnread = 1u;
+	DATA_READY_SET(1u);
+}
+
+/*******************************************************************************
+ * Function Name: setWriteSlot
+ ********************************************************************************
+ * Summary:
+ *    This function makes a notification slot the I2C slave write buffer
+ *
+ * Parameters:
+ *  slot:	slot returned by notificationSlotAlloc()
+ *
+ * Return:
+ *  void
+ *
+ *******************************************************************************/
+static void setWriteSlot(uint8 slot)
+{
+	wrSlot = slot;
+	wrBuf = notificationSlotBuffer(slot);
+	I2C_I2CSlaveInitWriteBuf(wrBuf, I2C_WRITE_BUFFER_SIZE);
+}
+
+/*******************************************************************************
+ * Function Name: initI2CWriteBuffer
+ ********************************************************************************
+ * Summary:
+ *    This function gives the I2C slave its first write buffer, call after
+ *    I2C_Start()
+ *
+ * Parameters:
+ *  void
+ *
+ * Return:
+ *  void
+ *
+ *******************************************************************************/
+void initI2CWriteBuffer(void)
 {
-	/* Wait for I2C master to complete a write */
-	if (0u != (I2C_I2CSlaveStatus() & I2C_I2C_SSTAT_WR_CMPLT))
+	if (NTF_SLOT_NONE == wrSlot)
 	{
-		/* Read the number of bytes transferred */
-		byteCnt = I2C_I2CSlaveGetWriteBufSize();
+		wrSlot = notificationSlotAlloc();
+	}
+	setWriteSlot(wrSlot);
+}
 
-		/* Clear the write status bits*/
-		I2C_I2CSlaveClearWriteStatus();
+/*******************************************************************************
+ * Function Name: completeWrite
+ ********************************************************************************
+ * Summary:
+ *    This function hands a completed master write to the main loop and points
+ *    the I2C slave at a free slot right away, a write that follows at once
+ *    lands in a buffer of its own. Only when no slot is free the write is
+ *    counted as dropped and the next one goes to the same buffer. Called by
+ *    the I2C interrupt.
+ *
+ * Parameters:
+ *  void
+ *
+ * Return:
+ *  void
+ *
+ *******************************************************************************/
+static void completeWrite(void)
+{
+	uint32 len = I2C_I2CSlaveGetWriteBufSize();
+	uint32 status = I2C_I2CSlaveClearWriteStatus();
+	I2C_WRITE_T *write;
+	uint8 next;
 
-		sendI2CNotification();
+	i2cStats.frames++;
+	if (0u != (status & I2C_I2C_SSTAT_WR_OVFL))
+	{
+		i2cStats.overflow++;
+	}
 
-		/* Clear the write buffer pointer so that the next write operation will
-		start from index 0 */
+	next = notificationSlotAlloc();
+	if (NTF_SLOT_NONE == next)
+	{
+		i2cStats.dropped++;
 		I2C_I2CSlaveClearWriteBuf();
+		return;
+	}
+
+	write = &i2cWrites[(i2cWriteHead + i2cWriteCount) % NTF_SLOT_COUNT];
+	write->time = appTimerNow();
+	write->slot = wrSlot;
+	write->len = (uint8)len;
+	i2cWriteCount++;
+
+	setWriteSlot(next);
+	postEvent(AppEventI2CWrite);
+}
+
+/*******************************************************************************
+ * Function Name: ipcEvent
+ ********************************************************************************
+ * Summary:
+ *    This function returns the event of a launcher message in the write buffer
+ *
+ * Parameters:
+ *  void
+ *
+ * Return:
+ *  uint16: event (little endian int16 at offset 0), 0 if not a launcher message
+ *
+ *******************************************************************************/
+static uint16 ipcEvent(void)
+{
+	if (byteCnt != IPC_MESSAGE_SIZE)
+	{
+		return 0u;
 	}
-	/* If the master has read the data , reset the read buffer pointer to 0
-	and clear the read status */
-	if (0u != (I2C_I2CSlaveStatus() & I2C_I2C_SSTAT_RD_CMPLT))
+	return (uint16)(frame[0] | ((uint16)frame[1] << 8));
+}
+
+/*******************************************************************************
+ * Function Name: forwardFrame
+ ********************************************************************************
+ * Summary:
+ *    This function hands the frame written by the I2C master to every path
+ *    to the phone: the advertising data, the HID consumer report and the
+ *    notification queue, which takes over its slot
+ *
+ * Parameters:
+ *  void
+ *
+ * Return:
+ *  void
+ *
+ *******************************************************************************/
+static void forwardFrame(void)
+{
+#ifdef ADV_BROADCAST
+	broadcastFrame(frame, (uint8)byteCnt);
+#endif /* ADV_BROADCAST */
+
+#ifdef HID_ENABLED
+	hidFrame(frame, (uint8)byteCnt);
+#endif /* HID_ENABLED */
+
+	/* Last, the slot may be freed and written again */
+	sendI2CNotification();
+}
+
+/*******************************************************************************
+ * Function Name: selectRegister
+ ********************************************************************************
+ * Summary:
+ *    This function points the I2C slave read buffer at a register, the master
+ *    may read it right away with a repeated start. Called by the I2C interrupt.
+ *
+ * Parameters:
+ *  address:	offset in the register file
+ *
+ * Return:
+ *  void
+ *
+ *******************************************************************************/
+static void selectRegister(uint8 address)
+{
+	if (address > sizeof(regFile))
 	{
-		/* Clear the read buffer pointer so that the next read operations starts
-		from index 0 */
+		address = sizeof(regFile);
+	}
+
+	I2C_I2CSlaveInitReadBuf((uint8 *)&regFile + address, sizeof(regFile) - address);
+	regSelected = 1u;
+}
+
+/*******************************************************************************
+ * Function Name: releaseRegister
+ ********************************************************************************
+ * Summary:
+ *    This function gives the read buffer back after a register read. Called
+ *    by the I2C interrupt.
+ *
+ * Parameters:
+ *  void
+ *
+ * Return:
+ *  void
+ *
+ *******************************************************************************/
+static void releaseRegister(void)
+{
+	I2C_I2CSlaveInitReadBuf(rdBuf, I2C_READ_BUFFER_SIZE);
+	regSelected = 0u;
+}
+
+/*******************************************************************************
+ * Function Name: I2C_I2C_ISR_ExitCallback
+ ********************************************************************************
+ * Summary:
+ *    This function is called at the end of every I2C interrupt. A completed
+ *    write is handed to the main loop together with a fresh write buffer, see
+ *    completeWrite(). A completed read lowers DATA_READY when it took the
+ *    published data and posts an event, handleI2CTraffic() then moves on to
+ *    the next read data. Both statuses are cleared here, each completion is
+ *    handled exactly once. Register accesses are handled
+ *    here, the read must follow the register address without delay, and the
+ *    main loop never sees them.
+ *
+ * Parameters:
+ *  void
+ *
+ * Return:
+ *  void
+ *
+ *******************************************************************************/
+void I2C_I2C_ISR_ExitCallback(void)
+{
+	uint32 status = I2C_I2CSlaveStatus();
+
+	/* Every completion is handled and its status cleared here, the next
+	completion raises the bit again */
+	if (0u != (status & I2C_I2C_SSTAT_WR_CMPLT))
+	{
+		if (I2C_REG_SELECT_SIZE == I2C_I2CSlaveGetWriteBufSize())
+		{
+			selectRegister(wrBuf[0]);
+			I2C_I2CSlaveClearWriteBuf();
+			(void)I2C_I2CSlaveClearWriteStatus();
+		}
+		else
+		{
+			/* A register address without a read */
+			if (0u != regSelected)
+			{
+				releaseRegister();
+			}
+			completeWrite();
+		}
+	}
+	if (0u != (status & I2C_I2C_SSTAT_RD_CMPLT))
+	{
+		if (0u != regSelected)
+		{
+			releaseRegister();
+		}
+		else if ((0u != rdUnread) && (0u == rdPending))
+		{
+			/* The master got the published data, a read of the buffer an
+			update is waiting to replace does not count */
+			rdUnread = 0u;
+			DATA_READY_SET(0u);
+			rdTaken = 1u;
+		}
 		I2C_I2CSlaveClearReadBuf();
+		(void)I2C_I2CSlaveClearReadStatus();
+
+		/* Also publishes read data held back by the read */
+		postEvent(AppEventI2CRead);
+	}
+}
+
+/*******************************************************************************
+ * Function Name: handleI2CTraffic
+ ********************************************************************************
+ * Summary:
+ *    This function handles the I2C read or write processing, call on
+ *    AppEventI2CWrite and AppEventI2CRead
+ *
+ * Parameters:
+ *  void
+ *
+ * Return:
+ *  void
+ *
+ *******************************************************************************/
+void handleI2CTraffic(void)
+{
+	const I2C_WRITE_T *write;
+	uint8 taken;
+
+	/* Forward the writes the I2C interrupt completed, in order */
+	if (0u != i2cWriteCount)
+	{
+		while (0u != i2cWriteCount)
+		{
+			write = &i2cWrites[i2cWriteHead];
+			frameSlot = write->slot;
+			frame = notificationSlotBuffer(frameSlot);
+			byteCnt = write->len;
+			frameTime = write->time;
+
+#ifdef LINK_WARM_UP
+			if (IPC_EVENT_TOUCH_INTENT == ipcEvent())
+			{
+				/* Intent hint is consumed by the bridge, the phone never sees it */
+				linkWarmUp();
+				notificationSlotFree(frameSlot);
+			}
+			else
+			{
+				linkActivity();
+				forwardFrame();
+			}
+#else
+			forwardFrame();
+#endif /* LINK_WARM_UP */
+
+			/* The interrupt adds behind the tail, only the head moves here */
+			I2C_DisableInt();
+			i2cWriteHead = (i2cWriteHead + 1u) % NTF_SLOT_COUNT;
+			i2cWriteCount--;
+			I2C_EnableInt();
+		}
+
+		handleNotificationQueue();
+	}
+	/* The next blob chunk raises the line again */
+	I2C_DisableInt();
+	taken = rdTaken;
+	rdTaken = 0u;
+	I2C_EnableInt();
+	if (0u != taken)
+	{
+		rxChunkRead();
 
 #ifdef RESET_I2C_READ_DATA
 		uint8 i;
 
 		for (i = 0; i < I2C_READ_BUFFER_SIZE; i++)
-			rdBuf[i] = 0;
+			rdNext[i] = 0;
 #endif /* RESET_I2C_READ_DATA */
+	}
 
-		/* Clear the read status bits */
-		I2C_I2CSlaveClearReadStatus();
+	/* Data written by the Client during a read is published now */
+	if (0u != rdPending)
+	{
+		I2C_DisableInt();
+		if ((0u != rdPending) && (0u == regSelected) && (0u == (I2C_I2CSlaveStatus() & I2C_I2C_SSTAT_RD_BUSY)))
+		{
+			publishReadBuffer();
+		}
+		I2C_EnableInt();
 	}
 }
 
@@ -76,7 +424,11 @@ void handleI2CTraffic(void)
  * Function Name: sendI2CNotification
  ********************************************************************************
  * Summary:
- *    This function notifies the I2C data written by I2C master to the Client
+ *    This function queues the I2C data written by I2C master for notification
+ *    to the Client. The frame stays in the notification slot the master wrote
+ *    it into and is sent by handleNotificationQueue(). A frame that is not
+ *    queued gives its slot back.
+ *    With STORE_AND_FORWARD frames are queued without a connection as well.
  *
  * Parameters:
  *  void
@@ -87,26 +439,153 @@ void handleI2CTraffic(void)
  *******************************************************************************/
 void sendI2CNotification(void)
 {
-	/* stores  notification data parameters */
-	CYBLE_GATTS_HANDLE_VALUE_NTF_T I2CHandle;
+	/* Launcher messages (launch requests) go ahead of stream frames */
+	uint8 lane = (0u != ipcEvent()) ? NtfLaneControl : NtfLaneBulk;
+#ifdef STORE_AND_FORWARD
+	/* Without notifications the frame is stored, the MTU of the next
+	connection is not known yet */
+	uint16 payloadMax = (0u != sendNotifications) ? notificationPayloadMax() : NTF_PAYLOAD_SIZE_MAX;
+#else
+	uint16 payloadMax = notificationPayloadMax();
+#endif /* STORE_AND_FORWARD */
 
+	/* Frames larger than the ATT MTU (e.g. trackpad stream frames) can never be sent */
+	if ((byteCnt + NTF_RECORD_HEADER) > payloadMax)
+	{
+		ntfStats.oversize++;
+		notificationSlotFree(frameSlot);
+		return;
+	}
+
+#ifdef STORE_AND_FORWARD
+	/* Queued until the Client enables notifications, handleNotificationQueue()
+	expires it if that takes too long */
+	(void)commitNotification(frameSlot, (uint8)byteCnt, lane, frameTime);
+#else
+	/* Send the I2C_read Characteristic to the client only when notification is enabled */
 	if (sendNotifications)
 	{
-		/* Package the notification data as part of I2C_read Characteristic*/
-		I2CHandle.attrHandle = CYBLE_VOICE_ASSISTANT_LAUNCHER_TXCHARACTERISTIC_CHAR_HANDLE;
-		// I2CHandle.attrHandle = CYBLE_I2C_READ_I2C_READ_DATA_CHAR_HANDLE;
+		(void)commitNotification(frameSlot, (uint8)byteCnt, lane, frameTime);
+	}
+	else
+	{
+		notificationSlotFree(frameSlot);
+	}
+#endif /* STORE_AND_FORWARD */
+}
+
+/*******************************************************************************
+ * Function Name: updateI2CReadData
+ ********************************************************************************
+ * Summary:
+ *    This function updates the data read by the I2C master with a write from
+ *    the Client. The data is prepared in the spare read buffer with the I2C
+ *    interrupt on, a pointer swap publishes it. A master read in progress
+ *    keeps the old buffer and the swap happens once it completed, so the
+ *    master never sees a half updated buffer.
+ *
+ * Parameters:
+ *  data:	value written by the Client
+ *  len:	number of bytes, bytes beyond it keep their previous value
+ *
+ * Return:
+ *  void
+ *
+ *******************************************************************************/
+void updateI2CReadData(const uint8 *data, uint16 len)
+{
+	if (len > I2C_READ_BUFFER_SIZE)
+	{
+		len = I2C_READ_BUFFER_SIZE;
+	}
 
-		I2CHandle.value.val = wrBuf;
+	/* Only this function and publishReadBuffer() touch rdNext, the I2C slave
+	reads rdBuf */
+	memcpy(rdNext, data, len);
+	if (0u == rdPending)
+	{
+		/* An unpublished update already holds the newest tail */
+		memcpy(&rdNext[len], &rdBuf[len], I2C_READ_BUFFER_SIZE - len);
+	}
 
-		I2CHandle.value.len = byteCnt;
+	/* Turn off I2C interrupt before swapping the read buffer */
+	I2C_DisableInt();
 
-		/* Send the I2C_read Characteristic to the client only when notification is enabled */
-		do
-		{
-			apiResult = CyBle_GattsNotification(cyBle_connHandle, &I2CHandle);
+	if ((0u != regSelected) || (0u != (I2C_I2CSlaveStatus() & I2C_I2C_SSTAT_RD_BUSY)))
+	{
+		rdPending = 1u;
+	}
+	else
+	{
+		publishReadBuffer();
+	}
 
-			CyBle_ProcessEvents();
+	/* Turn on I2C interrupt after the swap */
+	I2C_EnableInt();
+}
 
-		} while ((CYBLE_ERROR_OK != apiResult) && (CYBLE_STATE_CONNECTED == cyBle_state));
+/*******************************************************************************
+ * Function Name: handleI2CRegisters
+ ********************************************************************************
+ * Summary:
+ *    This function refreshes the register file from the bridge state. It is
+ *    skipped while the master reads a register, so it never sees a half
+ *    updated field.
+ *
+ * Parameters:
+ *  void
+ *
+ * Return:
+ *  void
+ *
+ *******************************************************************************/
+void handleI2CRegisters(void)
+{
+	uint8 state = 0u;
+	uint16 credits = notificationCredits();
+
+	if (CYBLE_ERROR_OK != apiResult)
+	{
+		regLastError = (uint8)apiResult;
+	}
+
+	if (CYBLE_STATE_CONNECTED == cyBle_state)
+	{
+		state |= I2C_REG_STATE_CONNECTED;
+		if (0u != sendNotifications)
+		{
+			state |= I2C_REG_STATE_NOTIFY;
+		}
+	}
+	else if (CYBLE_STATE_ADVERTISING == CyBle_GetState())
+	{
+		state |= I2C_REG_STATE_ADVERTISING;
+	}
+	if (0u != rdUnread)
+	{
+		state |= I2C_REG_STATE_DATA_READY;
+	}
+	if (NTF_CREDITS_UNLIMITED != credits)
+	{
+		state |= I2C_REG_STATE_PACED;
+	}
+
+	I2C_DisableInt();
+	if (0u == regSelected)
+	{
+		regFile.state = state;
+		regFile.lastError = regLastError;
+		regFile.ntfQueued = notificationQueued();
+		regFile.ntfFree = notificationFree();
+		regFile.mtu = notificationPayloadMax() + 3u;
+#ifdef LINK_WARM_UP
+		regFile.interval = (CYBLE_STATE_CONNECTED == cyBle_state) ? linkStats.interval : 0u;
+#endif /* LINK_WARM_UP */
+		regFile.rxLeft = rxBlobLeft();
+		regFile.i2cFrames = i2cStats.frames;
+		regFile.ntfSent = ntfStats.sent;
+		regFile.ntfDropped = ntfStats.dropped + ntfStats.oversize;
+		regFile.credits = (credits > 0xFFu) ? 0xFFu : (uint8)credits;
 	}
+	I2C_EnableInt();
 }
@@ -23,15 +23,71 @@
 
 #define I2C_READ_BUFFER_SIZE 61  /* Max supported by BCP */
 #define I2C_WRITE_BUFFER_SIZE 61 /* Max supported by BCP */
+#define I2C_WRITE_DEPTH 4u       /* frame slots kept for completed writes when the lanes are full */
+
+/* Launcher IPC message, see Message.h and AppEvent.h of VoiceAssistantLauncher */
+#define IPC_MESSAGE_SIZE 4u
+#define IPC_EVENT_LAUNCH_APP 1u       /* parameter is the app to launch */
+#define IPC_APP_VOICE_ASSISTANT 1u
+#define IPC_EVENT_TOUCH_INTENT 2u     /* finger landed on the touchpad, not forwarded */
+#define IPC_EVENT_TRACKPAD_STREAM 3u  /* up to I2C_WRITE_BUFFER_SIZE bytes, needs an ATT MTU of 65 with NOTIFY_PACKING */
+
+/* Data ready line to the launcher, the DATA_READY output pin in the schematic
+   wired to the DATA_READY input of the launcher. It goes high when new data is
+   published to the read buffer and low once the master read it, every publish
+   is a rising edge. */
+#define DATA_READY_SET(level) DATA_READY_Write(level)
+
+/* Register file. A write of a single byte selects a register, the read that
+   follows (repeated start or a new transfer) returns the register file from
+   there instead of the read buffer. The next read gets the read buffer again.
+   Fields are little endian, new fields are only appended. */
+#define I2C_REG_VERSION 2u
+#define I2C_REG_SELECT_SIZE 1u
+
+#define I2C_REG_STATE_CONNECTED 0x01u	/* a phone is connected */
+#define I2C_REG_STATE_ADVERTISING 0x02u /* advertising */
+#define I2C_REG_STATE_NOTIFY 0x04u		/* phone enabled notifications, frames are sent */
+#define I2C_REG_STATE_DATA_READY 0x08u	/* read buffer holds data not read yet */
+#define I2C_REG_STATE_PACED 0x10u		/* phone paces the notifications with credits */
+
+typedef CYPACKED struct
+{
+	uint8 version;	   /* 0x00 I2C_REG_VERSION */
+	uint8 size;		   /* 0x01 sizeof(I2C_REG_FILE_T) */
+	uint8 state;	   /* 0x02 I2C_REG_STATE_xxx */
+	uint8 lastError;   /* 0x03 last BLE API result other than CYBLE_ERROR_OK */
+	uint8 ntfQueued;   /* 0x04 frames in the notification queue */
+	uint8 ntfFree;	   /* 0x05 frames the queue takes before it drops */
+	uint16 mtu;		   /* 0x06 ATT MTU */
+	uint16 interval;   /* 0x08 connection interval (1.25 ms units), 0 if unknown */
+	uint16 rxLeft;	   /* 0x0A blob bytes not read yet */
+	uint32 i2cFrames;  /* 0x0C frames written by the master */
+	uint32 ntfSent;	   /* 0x10 frames notified */
+	uint32 ntfDropped; /* 0x14 frames dropped */
+	uint8 credits;	   /* 0x18 frames the phone takes, 0xFF for 255 and more (version 2) */
+} CYPACKED_ATTR I2C_REG_FILE_T;
 
 // #define RESET_I2C_READ_DATA
 // #define ENABLE_I2C_ONLY_WHEN_CONNECTED
 
-extern uint8 wrBuf[I2C_WRITE_BUFFER_SIZE]; /* I2C write buffer */
-extern uint8 rdBuf[I2C_READ_BUFFER_SIZE];  /* I2C read buffer */
+typedef struct
+{
+	uint32 frames;	 /* writes completed by the I2C master */
+	uint32 overflow; /* writes longer than I2C_WRITE_BUFFER_SIZE */
+	uint32 dropped;	 /* writes lost, every frame slot was taken */
+} I2C_STATS_T;
+
+extern I2C_STATS_T i2cStats;
+
+extern uint8 *wrBuf;                       /* I2C write buffer, a notification slot */
+extern uint8 *rdBuf;                       /* I2C read buffer, swapped on every Client write */
 // extern uint32 byteCnt;
 
 extern uint8 sendNotifications;
 
+extern void initI2CWriteBuffer(void);
 extern void sendI2CNotification(void);
 extern void handleI2CTraffic(void);
+extern void updateI2CReadData(const uint8 *data, uint16 len);
+extern void handleI2CRegisters(void);
@@ -0,0 +1,223 @@
+/*
+ * Copyright (C) 2022 teamprof.net@gmail.com or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include "app_Led.h"
+
+#ifdef LED_INDICATION
+static const LED_STEP_T disconnectSteps[] = {
+	{LedDisconnected, LED_DISCONNECT_MS},
+};
+
+const LED_PATTERN_T ledPatternDisconnect = {disconnectSteps, sizeof(disconnectSteps) / sizeof(disconnectSteps[0])};
+
+static uint8 ledState = LedOff;			 /* steady state shown when no pattern runs */
+static const LED_PATTERN_T *ledPattern; /* running pattern, NULL if none */
+static uint8 ledStep;					 /* current step of the pattern */
+static uint32 ledStepTime;				 /* time stamp of the current step */
+
+/*******************************************************************************
+ * Function Name: ledOutput
+ ********************************************************************************
+ * Summary:
+ *    This function drives the LEDs
+ *
+ * Parameters:
+ *  state:	LED_STATE_T
+ *
+ * Return:
+ *  void
+ *
+ *******************************************************************************/
+static void ledOutput(uint8 state)
+{
+	switch (state)
+	{
+	case LedDisconnected:
+		DISCON_LED_ON();
+		break;
+
+	case LedConnected:
+		CONNECT_LED_ON();
+		break;
+
+	case LedAdvertising:
+		ADV_LED_ON();
+		break;
+
+	default:
+		ALL_LED_OFF();
+		break;
+	}
+}
+
+/*******************************************************************************
+ * Function Name: ledCurrent
+ ********************************************************************************
+ * Summary:
+ *    This function returns what the LEDs show right now
+ *
+ * Parameters:
+ *  void
+ *
+ * Return:
+ *  uint8: LED_STATE_T
+ *
+ *******************************************************************************/
+static uint8 ledCurrent(void)
+{
+	return (NULL != ledPattern) ? ledPattern->steps[ledStep].state : ledState;
+}
+
+/*******************************************************************************
+ * Function Name: ledShow
+ ********************************************************************************
+ * Summary:
+ *    This function sets the steady state, a running pattern keeps the LEDs
+ *    until it ends
+ *
+ * Parameters:
+ *  state:	LED_STATE_T
+ *
+ * Return:
+ *  void
+ *
+ *******************************************************************************/
+void ledShow(uint8 state)
+{
+	ledState = state;
+	if (NULL == ledPattern)
+	{
+		ledOutput(state);
+	}
+}
+
+/*******************************************************************************
+ * Function Name: ledPlay
+ ********************************************************************************
+ * Summary:
+ *    This function starts a pattern, the steady state is shown again once it
+ *    ends. It never blocks, the steps are timed by handleLed().
+ *
+ * Parameters:
+ *  pattern:	steps to show
+ *
+ * Return:
+ *  void
+ *
+ *******************************************************************************/
+void ledPlay(const LED_PATTERN_T *pattern)
+{
+	ledPattern = pattern;
+	ledStep = 0u;
+	ledStepTime = appTimerNow();
+	ledOutput(ledCurrent());
+
+	/* Deep sleep turns the LEDs off, keep the pattern visible */
+	powerVote(PowerVoteLed, PowerSleep);
+}
+
+/*******************************************************************************
+ * Function Name: ledStop
+ ********************************************************************************
+ * Summary:
+ *    This function ends a running pattern and shows the steady state
+ *
+ * Parameters:
+ *  void
+ *
+ * Return:
+ *  void
+ *
+ *******************************************************************************/
+void ledStop(void)
+{
+	ledPattern = NULL;
+	powerVote(PowerVoteLed, PowerDeepSleep);
+	ledOutput(ledState);
+}
+
+/*******************************************************************************
+ * Function Name: handleLed
+ ********************************************************************************
+ * Summary:
+ *    This function moves a running pattern to its next step when the current
+ *    one has expired, call from the main loop
+ *
+ * Parameters:
+ *  void
+ *
+ * Return:
+ *  void
+ *
+ *******************************************************************************/
+void handleLed(void)
+{
+	if ((NULL == ledPattern) ||
+		(appTimerElapsed(ledStepTime) < APP_TIMER_MS(ledPattern->steps[ledStep].duration)))
+	{
+		return;
+	}
+
+	ledStepTime += APP_TIMER_MS(ledPattern->steps[ledStep].duration);
+	ledStep++;
+	if (ledStep >= ledPattern->count)
+	{
+		ledStop();
+		return;
+	}
+	ledOutput(ledCurrent());
+}
+
+/*******************************************************************************
+ * Function Name: ledSleep
+ ********************************************************************************
+ * Summary:
+ *    This function turns the LEDs off before deep sleep
+ *
+ * Parameters:
+ *  void
+ *
+ * Return:
+ *  void
+ *
+ *******************************************************************************/
+void ledSleep(void)
+{
+	ALL_LED_OFF();
+}
+
+/*******************************************************************************
+ * Function Name: ledWakeup
+ ********************************************************************************
+ * Summary:
+ *    This function shows the LEDs again after deep sleep
+ *
+ * Parameters:
+ *  void
+ *
+ * Return:
+ *  void
+ *
+ *******************************************************************************/
+void ledWakeup(void)
+{
+	ledOutput(ledCurrent());
+}
+#endif /* LED_INDICATION */
@@ -0,0 +1,54 @@
+/*
+ * Copyright (C) 2022 teamprof.net@gmail.com or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#pragma once
+#include "main.h"
+
+#define LED_DISCONNECT_MS 3000u /* disconnect indication, advertising restarts meanwhile */
+
+/* LED output, one of the LED.h macros */
+typedef enum
+{
+	LedOff,			 /* ALL_LED_OFF() */
+	LedDisconnected, /* DISCON_LED_ON() */
+	LedConnected,	 /* CONNECT_LED_ON() */
+	LedAdvertising	 /* ADV_LED_ON() */
+} LED_STATE_T;
+
+typedef struct
+{
+	uint8 state;	 /* LED_STATE_T */
+	uint16 duration; /* ms */
+} LED_STEP_T;
+
+typedef struct
+{
+	const LED_STEP_T *steps;
+	uint8 count;
+} LED_PATTERN_T;
+
+extern const LED_PATTERN_T ledPatternDisconnect;
+
+extern void ledShow(uint8 state);
+extern void ledPlay(const LED_PATTERN_T *pattern);
+extern void ledStop(void);
+extern void handleLed(void);
+extern void ledSleep(void);
+extern void ledWakeup(void);
@@ -0,0 +1,346 @@
+/*
+ * Copyright (C) 2022 teamprof.net@gmail.com or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include "app_Link.h"
+
+#ifdef LINK_WARM_UP
+LINK_STATS_T linkStats;
+
+static uint8 linkRegime;		/* regime of the parameters in use */
+static uint8 linkTarget;		/* regime last asked for, LinkRegimeCentral if none */
+static uint8 linkPending;		/* request waiting for the L2CAP response */
+static uint32 linkRequestTime;	/* time stamp of the last request */
+static uint32 linkBackoffMs;	/* delay before asking again after a rejection */
+static uint32 linkActiveTime;	/* time stamp of the last launcher activity */
+static uint32 linkAccountTime; /* regime time accounted up to here */
+
+/*******************************************************************************
+ * Function Name: linkRegimeOf
+ ********************************************************************************
+ * Summary:
+ *    This function classifies a connection interval
+ *
+ * Parameters:
+ *  interval:	connection interval (1.25 ms units)
+ *
+ * Return:
+ *  uint8: LINK_REGIME_T
+ *
+ *******************************************************************************/
+static uint8 linkRegimeOf(uint16 interval)
+{
+	if (interval <= LINK_FAST_INTERVAL_MAX)
+	{
+		return LinkRegimeFast;
+	}
+	if (interval >= LINK_SLOW_INTERVAL_MIN)
+	{
+		return LinkRegimeSlow;
+	}
+	return LinkRegimeCentral;
+}
+
+/*******************************************************************************
+ * Function Name: linkAccount
+ ********************************************************************************
+ * Summary:
+ *    This function adds the time since the last call to the current regime
+ *
+ * Parameters:
+ *  void
+ *
+ * Return:
+ *  void
+ *
+ *******************************************************************************/
+static void linkAccount(void)
+{
+	uint32 ms = APP_TIMER_TO_MS(appTimerElapsed(linkAccountTime));
+
+	/* Only whole milliseconds are moved, the remainder stays for the next call */
+	linkStats.timeMs[linkRegime] += ms;
+	linkAccountTime += APP_TIMER_MS(ms);
+}
+
+/*******************************************************************************
+ * Function Name: requestLinkParam
+ ********************************************************************************
+ * Summary:
+ *    This function asks the Central to switch to the fast or slow parameters
+ *
+ * Parameters:
+ *  regime:	LinkRegimeFast or LinkRegimeSlow
+ *
+ * Return:
+ *  void
+ *
+ *******************************************************************************/
+static void requestLinkParam(uint8 regime)
+{
+	CYBLE_GAP_CONN_UPDATE_PARAM_T connParam;
+
+	if (LinkRegimeFast == regime)
+	{
+		connParam.connIntvMin = LINK_FAST_INTERVAL_MIN;
+		connParam.connIntvMax = LINK_FAST_INTERVAL_MAX;
+		connParam.connLatency = LINK_FAST_LATENCY;
+	}
+	else
+	{
+		connParam.connIntvMin = LINK_SLOW_INTERVAL_MIN;
+		connParam.connIntvMax = LINK_SLOW_INTERVAL_MAX;
+		connParam.connLatency = LINK_SLOW_LATENCY;
+	}
+	connParam.supervisionTO = LINK_SUPERVISION_TIMEOUT;
+
+	if (CYBLE_ERROR_OK == CyBle_L2capLeConnectionParamUpdateRequest(cyBle_connHandle.bdHandle, &connParam))
+	{
+		linkStats.requests++;
+		linkTarget = regime;
+		linkPending = 1u;
+		linkRequestTime = appTimerNow();
+	}
+}
+
+/*******************************************************************************
+ * Function Name: linkBackOff
+ ********************************************************************************
+ * Summary:
+ *    This function delays the next request, doubling the delay every time
+ *
+ * Parameters:
+ *  void
+ *
+ * Return:
+ *  void
+ *
+ *******************************************************************************/
+static void linkBackOff(void)
+{
+	linkBackoffMs = (0u == linkBackoffMs) ? LINK_BACKOFF_MIN_MS : (linkBackoffMs * 2u);
+	if (linkBackoffMs > LINK_BACKOFF_MAX_MS)
+	{
+		linkBackoffMs = LINK_BACKOFF_MAX_MS;
+	}
+	linkRequestTime = appTimerNow();
+
+	/* Ask again once the back-off expired */
+	linkTarget = LinkRegimeCentral;
+}
+
+/*******************************************************************************
+ * Function Name: linkConnected
+ ********************************************************************************
+ * Summary:
+ *    This function starts the policy for a new connection, call on
+ *    CYBLE_EVT_GAP_DEVICE_CONNECTED. The link counts as active so that the
+ *    slow parameters are only requested after a quiet period.
+ *
+ * Parameters:
+ *  interval:	connection interval chosen by the Central (1.25 ms units)
+ *  latency:	slave latency chosen by the Central
+ *
+ * Return:
+ *  void
+ *
+ *******************************************************************************/
+void linkConnected(uint16 interval, uint16 latency)
+{
+	linkStats.interval = interval;
+	linkStats.latency = latency;
+	linkRegime = linkRegimeOf(interval);
+	linkTarget = LinkRegimeCentral;
+	linkPending = 0u;
+	linkBackoffMs = 0u;
+	linkActiveTime = appTimerNow();
+	linkAccountTime = linkActiveTime;
+}
+
+/*******************************************************************************
+ * Function Name: linkDisconnected
+ ********************************************************************************
+ * Summary:
+ *    This function closes the regime accounting, call on
+ *    CYBLE_EVT_GAP_DEVICE_DISCONNECTED
+ *
+ * Parameters:
+ *  void
+ *
+ * Return:
+ *  void
+ *
+ *******************************************************************************/
+void linkDisconnected(void)
+{
+	linkAccount();
+	linkPending = 0u;
+	linkTarget = LinkRegimeCentral;
+}
+
+/*******************************************************************************
+ * Function Name: linkUpdateResponse
+ ********************************************************************************
+ * Summary:
+ *    This function handles the Central's answer to an update request, call on
+ *    CYBLE_EVT_L2CAP_CONN_PARAM_UPDATE_RSP. A rejection backs off before the
+ *    next request.
+ *
+ * Parameters:
+ *  result:	0 accepted, 1 rejected
+ *
+ * Return:
+ *  void
+ *
+ *******************************************************************************/
+void linkUpdateResponse(uint16 result)
+{
+	linkPending = 0u;
+
+	if (0u != result)
+	{
+		linkStats.rejected++;
+		linkBackOff();
+	}
+}
+
+/*******************************************************************************
+ * Function Name: linkUpdated
+ ********************************************************************************
+ * Summary:
+ *    This function records the parameters in use, call on
+ *    CYBLE_EVT_GAP_CONNECTION_UPDATE_COMPLETE. If the Central picked values
+ *    outside the requested regime the next request also backs off.
+ *
+ * Parameters:
+ *  interval:	connection interval (1.25 ms units)
+ *  latency:	slave latency
+ *
+ * Return:
+ *  void
+ *
+ *******************************************************************************/
+void linkUpdated(uint16 interval, uint16 latency)
+{
+	linkAccount();
+
+	linkStats.updates++;
+	linkStats.interval = interval;
+	linkStats.latency = latency;
+	linkRegime = linkRegimeOf(interval);
+
+	if (linkRegime == linkTarget)
+	{
+		linkBackoffMs = 0u;
+	}
+	else if (LinkRegimeCentral != linkTarget)
+	{
+		linkBackOff();
+	}
+}
+
+/*******************************************************************************
+ * Function Name: linkActivity
+ ********************************************************************************
+ * Summary:
+ *    This function records launcher traffic, it keeps the link in fast mode
+ *
+ * Parameters:
+ *  void
+ *
+ * Return:
+ *  void
+ *
+ *******************************************************************************/
+void linkActivity(void)
+{
+	linkActiveTime = appTimerNow();
+}
+
+/*******************************************************************************
+ * Function Name: linkWarmUp
+ ********************************************************************************
+ * Summary:
+ *    This function is called when the launcher reports a finger on the touchpad.
+ *    It requests a short connection interval ahead of the launch notification,
+ *    so that the link latency is hidden behind the gesture.
+ *
+ * Parameters:
+ *  void
+ *
+ * Return:
+ *  void
+ *
+ *******************************************************************************/
+void linkWarmUp(void)
+{
+	linkActivity();
+	handleLinkPolicy();
+}
+
+/*******************************************************************************
+ * Function Name: handleLinkPolicy
+ ********************************************************************************
+ * Summary:
+ *    This function asks for the fast parameters while the launcher is active
+ *    and for the slow ones after a quiet timeout. Only one request is in
+ *    flight at a time and a rejected one is not repeated before the back-off
+ *    expired.
+ *
+ * Parameters:
+ *  void
+ *
+ * Return:
+ *  void
+ *
+ *******************************************************************************/
+void handleLinkPolicy(void)
+{
+	uint8 wanted;
+
+	if (CYBLE_STATE_CONNECTED != cyBle_state)
+	{
+		return;
+	}
+
+	linkAccount();
+
+	if (0u != linkPending)
+	{
+		if (appTimerElapsed(linkRequestTime) < APP_TIMER_MS(LINK_RESPONSE_TIMEOUT_MS))
+		{
+			return;
+		}
+		linkStats.timeouts++;
+		linkPending = 0u;
+		linkBackOff();
+	}
+
+	if ((0u != linkBackoffMs) && (appTimerElapsed(linkRequestTime) < APP_TIMER_MS(linkBackoffMs)))
+	{
+		return;
+	}
+
+	wanted = (appTimerElapsed(linkActiveTime) < APP_TIMER_MS(LINK_QUIET_TIMEOUT_MS)) ? LinkRegimeFast : LinkRegimeSlow;
+	if ((wanted != linkRegime) && (wanted != linkTarget))
+	{
+		requestLinkParam(wanted);
+	}
+}
+#endif /* LINK_WARM_UP */
@@ -0,0 +1,70 @@
+/*
+ * Copyright (C) 2022 teamprof.net@gmail.com or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#pragma once
+#include "main.h"
+
+/* Connection parameters requested while the launcher is active (1.25 ms units) */
+#define LINK_FAST_INTERVAL_MIN 6u  /* 7.5 ms */
+#define LINK_FAST_INTERVAL_MAX 12u /* 15 ms */
+#define LINK_FAST_LATENCY 0u
+
+/* Connection parameters requested once the launcher went quiet (1.25 ms units) */
+#define LINK_SLOW_INTERVAL_MIN 80u  /* 100 ms */
+#define LINK_SLOW_INTERVAL_MAX 160u /* 200 ms */
+#define LINK_SLOW_LATENCY 4u
+
+#define LINK_SUPERVISION_TIMEOUT 400u /* 4 s, 10 ms units */
+#define LINK_QUIET_TIMEOUT_MS 3000u   /* relax the link after this much silence */
+
+/* A rejected request is retried after a back-off that doubles up to the maximum */
+#define LINK_BACKOFF_MIN_MS 1000u
+#define LINK_BACKOFF_MAX_MS 32000u
+#define LINK_RESPONSE_TIMEOUT_MS 30000u /* L2CAP signalling timeout */
+
+/* Connection parameter regimes, classified by the interval in use */
+typedef enum
+{
+	LinkRegimeCentral, /* chosen by the Central, neither fast nor slow */
+	LinkRegimeFast,
+	LinkRegimeSlow,
+	LinkRegimeCount
+} LINK_REGIME_T;
+
+typedef struct
+{
+	uint32 timeMs[LinkRegimeCount]; /* connected time spent in each regime */
+	uint32 requests;				 /* update requests sent */
+	uint32 rejected;				 /* update requests rejected by the Central */
+	uint32 timeouts;				 /* update requests never answered */
+	uint32 updates;					 /* parameters changed by the controller */
+	uint16 interval;				 /* interval in use (1.25 ms units) */
+	uint16 latency;					 /* slave latency in use */
+} LINK_STATS_T;
+
+extern LINK_STATS_T linkStats;
+
+extern void linkConnected(uint16 interval, uint16 latency);
+extern void linkDisconnected(void);
+extern void linkUpdateResponse(uint16 result);
+extern void linkUpdated(uint16 interval, uint16 latency);
+extern void linkActivity(void);
+extern void linkWarmUp(void);
+extern void handleLinkPolicy(void);
@@ -0,0 +1,704 @@
+/*
+ * Copyright (C) 2022 teamprof.net@gmail.com or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include <string.h>
+#include "app_Notify.h"
+
+/* Frames live in a pool of slots and the lanes queue slot numbers. The I2C
+   interrupt takes a free slot as its next write buffer and hands the written
+   one to the main loop, which queues it in a lane. A frame is never copied
+   until it is packed. */
+#if (NTF_SLOT_COUNT > 32u)
+#error "ntfFreeSlots has one bit per slot"
+#endif
+
+typedef struct
+{
+	uint32 time; /* time stamp of the I2C write */
+	uint8 len;
+	uint8 data[NTF_RECORD_HEADER + I2C_WRITE_BUFFER_SIZE]; /* [length] frame */
+} NTF_ENTRY_T;
+
+/* Lane of queued frames, a ring of slot numbers */
+typedef struct
+{
+	uint8 *slot;
+	uint8 slots; /* entries of slot[] */
+	uint8 head;	 /* oldest entry */
+	uint8 count; /* number of entries */
+} NTF_QUEUE_T;
+
+NTF_STATS_T ntfStats = {.latencyMin = 0xFFFFFFFFu};
+
+static NTF_ENTRY_T ntfSlot[NTF_SLOT_COUNT];
+static volatile uint32 ntfFreeSlots = (uint32)((1ull << NTF_SLOT_COUNT) - 1u); /* one bit per free slot */
+static uint8 ntfControl[NTF_CONTROL_DEPTH];
+static uint8 ntfBulk[NTF_QUEUE_DEPTH];
+static NTF_QUEUE_T ntfQueue[NtfLaneCount] = {
+	{ntfControl, NTF_CONTROL_DEPTH, 0u, 0u},
+	{ntfBulk, NTF_QUEUE_DEPTH, 0u, 0u}};
+static uint8 ntfStarve; /* control notifications in a row while bulk frames waited */
+static uint8 stackBusy; /* set by CYBLE_EVT_STACK_BUSY_STATUS */
+static uint16 ntfMtu = CYBLE_GATT_DEFAULT_MTU; /* ATT MTU of the current connection */
+static uint8 ntfPayload[NTF_PAYLOAD_SIZE_MAX]; /* value of a packed notification */
+static uint16 ntfCredits = NTF_CREDITS_UNLIMITED; /* frames the phone takes */
+
+/*******************************************************************************
+ * Function Name: queueEntry
+ ********************************************************************************
+ * Summary:
+ *    This function returns an entry of a lane counted from its oldest one
+ *
+ * Parameters:
+ *  queue:	lane
+ *  index:	0 for the oldest entry, up to queue->count - 1
+ *
+ * Return:
+ *  NTF_ENTRY_T *: entry
+ *
+ *******************************************************************************/
+static NTF_ENTRY_T *queueEntry(const NTF_QUEUE_T *queue, uint8 index)
+{
+	return &ntfSlot[queue->slot[(queue->head + index) % queue->slots]];
+}
+
+/*******************************************************************************
+ * Function Name: queuePop
+ ********************************************************************************
+ * Summary:
+ *    This function removes the oldest entries of a lane and frees their slots
+ *
+ * Parameters:
+ *  queue:	lane
+ *  frames:	number of entries, up to queue->count
+ *
+ * Return:
+ *  void
+ *
+ *******************************************************************************/
+static void queuePop(NTF_QUEUE_T *queue, uint8 frames)
+{
+	while (0u != frames--)
+	{
+		notificationSlotFree(queue->slot[queue->head]);
+		queue->head = (queue->head + 1u) % queue->slots;
+		queue->count--;
+	}
+}
+
+/*******************************************************************************
+ * Function Name: packNotification
+ ********************************************************************************
+ * Summary:
+ *    This function prepares the value of the next notification. A single
+ *    frame is sent straight from its queue slot. With NOTIFY_PACKING further
+ *    frames of the same lane that fit are copied behind it into ntfPayload,
+ *    each one prefixed by its length.
+ *
+ * Parameters:
+ *  queue:	lane to send from, not empty
+ *  val:	returns the notification value
+ *  len:	returns the number of payload bytes
+ *  maxFrames:	number of frames that may be packed, at least 1
+ *
+ * Return:
+ *  uint8: number of frames packed, 0 if the head frame does not fit
+ *
+ *******************************************************************************/
+static uint8 packNotification(const NTF_QUEUE_T *queue, uint8 **val, uint16 *len, uint16 maxFrames)
+{
+	uint16 payloadMax = notificationPayloadMax();
+	NTF_ENTRY_T *entry = queueEntry(queue, 0u);
+	uint8 frames = 1u;
+
+	if ((NTF_RECORD_HEADER + entry->len) > payloadMax)
+	{
+		return 0u;
+	}
+	*val = entry->data;
+	*len = NTF_RECORD_HEADER + entry->len;
+
+#ifdef NOTIFY_PACKING
+	while ((frames < queue->count) && (frames < maxFrames))
+	{
+		entry = queueEntry(queue, frames);
+		if ((*len + NTF_RECORD_HEADER + entry->len) > payloadMax)
+		{
+			break;
+		}
+
+		if (1u == frames)
+		{
+			memcpy(ntfPayload, *val, *len);
+			*val = ntfPayload;
+		}
+		memcpy(&ntfPayload[*len], entry->data, NTF_RECORD_HEADER + entry->len);
+		*len += NTF_RECORD_HEADER + entry->len;
+		frames++;
+	}
+#endif /* NOTIFY_PACKING */
+
+	return frames;
+}
+
+/*******************************************************************************
+ * Function Name: selectLane
+ ********************************************************************************
+ * Summary:
+ *    This function picks the lane of the next notification. Control frames go
+ *    first, but after NTF_STARVE_MAX control notifications in a row one bulk
+ *    notification gets through.
+ *
+ * Parameters:
+ *  void
+ *
+ * Return:
+ *  uint8: NtfLaneControl or NtfLaneBulk
+ *
+ *******************************************************************************/
+static uint8 selectLane(void)
+{
+	if ((0u != ntfQueue[NtfLaneControl].count) &&
+		((0u == ntfQueue[NtfLaneBulk].count) || (ntfStarve < NTF_STARVE_MAX)))
+	{
+		return NtfLaneControl;
+	}
+	return NtfLaneBulk;
+}
+
+#ifdef STORE_AND_FORWARD
+/*******************************************************************************
+ * Function Name: expireNotifications
+ ********************************************************************************
+ * Summary:
+ *    This function drops the frames that waited longer than NTF_STORE_AGE_MS,
+ *    a launch request the user gave up on must not fire on reconnect
+ *
+ * Parameters:
+ *  void
+ *
+ * Return:
+ *  void
+ *
+ *******************************************************************************/
+static void expireNotifications(void)
+{
+	NTF_QUEUE_T *queue;
+	uint8 lane;
+
+	for (lane = 0u; lane < NtfLaneCount; lane++)
+	{
+		queue = &ntfQueue[lane];
+		while ((0u != queue->count) && (appTimerElapsed(queueEntry(queue, 0u)->time) > APP_TIMER_MS(NTF_STORE_AGE_MS)))
+		{
+			ntfStats.expired++;
+			queuePop(queue, 1u);
+		}
+	}
+}
+#endif /* STORE_AND_FORWARD */
+
+/*******************************************************************************
+ * Function Name: recordLatency
+ ********************************************************************************
+ * Summary:
+ *    This function adds the queueing time of the frames at the head of a
+ *    lane to the latency statistics
+ *
+ * Parameters:
+ *  lane:	lane the frames were sent from
+ *  frames:	number of frames just sent
+ *
+ * Return:
+ *  void
+ *
+ *******************************************************************************/
+static void recordLatency(uint8 lane, uint8 frames)
+{
+	NTF_LANE_STATS_T *laneStats = &ntfStats.lane[lane];
+	uint32 now = appTimerNow();
+	uint32 ticks;
+	uint8 i;
+
+	for (i = 0; i < frames; i++)
+	{
+		ticks = now - queueEntry(&ntfQueue[lane], i)->time;
+
+		ntfStats.latencySum += ticks;
+		if (ticks < ntfStats.latencyMin)
+		{
+			ntfStats.latencyMin = ticks;
+		}
+		if (ticks > ntfStats.latencyMax)
+		{
+			ntfStats.latencyMax = ticks;
+		}
+
+		laneStats->latencySum += ticks;
+		if (ticks > laneStats->latencyMax)
+		{
+			laneStats->latencyMax = ticks;
+		}
+	}
+	laneStats->sent += frames;
+}
+
+/*******************************************************************************
+ * Function Name: notificationSlotAlloc
+ ********************************************************************************
+ * Summary:
+ *    This function takes a free slot for the I2C slave to write a frame into.
+ *    Safe to call from the I2C interrupt.
+ *
+ * Parameters:
+ *  void
+ *
+ * Return:
+ *  uint8: slot, NTF_SLOT_NONE if all slots are taken
+ *
+ *******************************************************************************/
+uint8 notificationSlotAlloc(void)
+{
+	uint8 interruptStatus = CyEnterCriticalSection();
+	uint8 slot;
+
+	for (slot = 0u; slot < NTF_SLOT_COUNT; slot++)
+	{
+		if (0u != (ntfFreeSlots & (1u << slot)))
+		{
+			ntfFreeSlots &= ~(1u << slot);
+			break;
+		}
+	}
+	CyExitCriticalSection(interruptStatus);
+
+	return (slot < NTF_SLOT_COUNT) ? slot : NTF_SLOT_NONE;
+}
+
+/*******************************************************************************
+ * Function Name: notificationSlotFree
+ ********************************************************************************
+ * Summary:
+ *    This function gives back a slot that holds no queued frame, e.g. a frame
+ *    the bridge consumed itself
+ *
+ * Parameters:
+ *  slot:	slot returned by notificationSlotAlloc()
+ *
+ * Return:
+ *  void
+ *
+ *******************************************************************************/
+void notificationSlotFree(uint8 slot)
+{
+	uint8 interruptStatus = CyEnterCriticalSection();
+
+	ntfFreeSlots |= (1u << slot);
+	CyExitCriticalSection(interruptStatus);
+}
+
+/*******************************************************************************
+ * Function Name: notificationSlotBuffer
+ ********************************************************************************
+ * Summary:
+ *    This function returns the frame buffer of a slot, room is left in front
+ *    of it for the record header
+ *
+ * Parameters:
+ *  slot:	slot returned by notificationSlotAlloc()
+ *
+ * Return:
+ *  uint8 *: buffer of I2C_WRITE_BUFFER_SIZE bytes
+ *
+ *******************************************************************************/
+uint8 *notificationSlotBuffer(uint8 slot)
+{
+	return &ntfSlot[slot].data[NTF_RECORD_HEADER];
+}
+
+/*******************************************************************************
+ * Function Name: commitNotification
+ ********************************************************************************
+ * Summary:
+ *    This function queues the frame the I2C master wrote into a slot, the
+ *    slot belongs to the queue from now on. A control frame that finds the
+ *    control lane full is queued as a bulk frame rather than dropped.
+ *
+ * Parameters:
+ *  slot:	slot holding the frame
+ *  len:	number of bytes, up to I2C_WRITE_BUFFER_SIZE
+ *  lane:	NtfLaneControl or NtfLaneBulk
+ *  time:	time stamp of the I2C write
+ *
+ * Return:
+ *  uint8: 1 if the frame was queued, 0 if it was dropped
+ *
+ *******************************************************************************/
+uint8 commitNotification(uint8 slot, uint8 len, uint8 lane, uint32 time)
+{
+	NTF_ENTRY_T *entry = &ntfSlot[slot];
+	NTF_QUEUE_T *queue;
+	uint8 queued;
+
+	entry->time = time;
+	entry->len = len;
+#ifdef NOTIFY_PACKING
+	entry->data[0] = len;
+#endif /* NOTIFY_PACKING */
+
+	if ((NtfLaneControl == lane) && (ntfQueue[NtfLaneControl].count >= NTF_CONTROL_DEPTH))
+	{
+		lane = NtfLaneBulk;
+	}
+	queue = &ntfQueue[lane];
+
+	if (queue->count >= queue->slots)
+	{
+		ntfStats.dropped++;
+		ntfStats.lane[lane].dropped++;
+
+#if (NTF_QUEUE_POLICY == NTF_DROP_OLDEST)
+		queuePop(queue, 1u);
+#else
+		notificationSlotFree(slot);
+		return 0u;
+#endif
+	}
+	queue->slot[(queue->head + queue->count) % queue->slots] = slot;
+	queue->count++;
+
+	ntfStats.queued++;
+	queued = notificationQueued();
+	if (queued > ntfStats.highWater)
+	{
+		ntfStats.highWater = queued;
+	}
+	return 1u;
+}
+
+/*******************************************************************************
+ * Function Name: handleNotificationQueue
+ ********************************************************************************
+ * Summary:
+ *    This function hands queued frames to the BLE stack as long as it has free
+ *    buffers. Frames that piled up while the stack was busy are packed into
+ *    as few notifications as the ATT MTU allows. It returns as soon as the
+ *    stack is busy, the queue is drained again on the next call after
+ *    CYBLE_EVT_STACK_BUSY_STATUS reported free.
+ *    Control frames go ahead of bulk frames, see selectLane().
+ *    With STORE_AND_FORWARD frames are kept while there is no connection or
+ *    the CCCD is off, and flushed in order once notifications are enabled.
+ *    With CREDIT_FLOW no more frames are sent than the phone credited.
+ *
+ * Parameters:
+ *  void
+ *
+ * Return:
+ *  void
+ *
+ *******************************************************************************/
+void handleNotificationQueue(void)
+{
+	/* stores  notification data parameters */
+	CYBLE_GATTS_HANDLE_VALUE_NTF_T I2CHandle;
+	NTF_QUEUE_T *queue;
+	uint8 *val;
+	uint16 len;
+	uint8 frames;
+	uint8 lane;
+
+#ifdef STORE_AND_FORWARD
+	expireNotifications();
+#endif /* STORE_AND_FORWARD */
+
+	while ((0u != notificationQueued()) && (0u == stackBusy) && (0u != ntfCredits))
+	{
+		if ((CYBLE_STATE_CONNECTED != cyBle_state) || (0u == sendNotifications))
+		{
+#ifndef STORE_AND_FORWARD
+			clearNotificationQueue();
+#endif /* STORE_AND_FORWARD */
+			break;
+		}
+
+		lane = selectLane();
+		queue = &ntfQueue[lane];
+		frames = packNotification(queue, &val, &len, ntfCredits);
+		if (0u == frames)
+		{
+			/* Head frame is larger than the ATT MTU, it can never be sent */
+			ntfStats.oversize++;
+			queuePop(queue, 1u);
+			continue;
+		}
+
+		/* Package the notification data as part of I2C_read Characteristic*/
+		I2CHandle.attrHandle = CYBLE_VOICE_ASSISTANT_LAUNCHER_TXCHARACTERISTIC_CHAR_HANDLE;
+		I2CHandle.value.val = val;
+		I2CHandle.value.len = len;
+
+		apiResult = CyBle_GattsNotification(cyBle_connHandle, &I2CHandle);
+		if ((CYBLE_ERROR_MEMORY_ALLOCATION_FAILED == apiResult) || (CYBLE_ERROR_INSUFFICIENT_RESOURCES == apiResult))
+		{
+			/* No buffer in the stack, keep the frames, more may be packed next time */
+			ntfStats.retries++;
+			break;
+		}
+
+		if (CYBLE_ERROR_OK == apiResult)
+		{
+			ntfStats.sent += frames;
+			ntfStats.packets++;
+			recordLatency(lane, frames);
+			if (NTF_CREDITS_UNLIMITED != ntfCredits)
+			{
+				ntfCredits -= frames;
+			}
+			bondNotified();
+		}
+		else
+		{
+			ntfStats.dropped += frames;
+			ntfStats.lane[lane].dropped += frames;
+		}
+		queuePop(queue, frames);
+
+		/* Count the control notifications bulk frames waited for */
+		ntfStarve = ((NtfLaneControl == lane) && (0u != ntfQueue[NtfLaneBulk].count)) ? (uint8)(ntfStarve + 1u) : 0u;
+	}
+}
+
+/*******************************************************************************
+ * Function Name: clearNotificationQueue
+ ********************************************************************************
+ * Summary:
+ *    This function drops all queued frames, e.g. on disconnect
+ *
+ * Parameters:
+ *  void
+ *
+ * Return:
+ *  void
+ *
+ *******************************************************************************/
+void clearNotificationQueue(void)
+{
+	queuePop(&ntfQueue[NtfLaneBulk], ntfQueue[NtfLaneBulk].count);
+	queuePop(&ntfQueue[NtfLaneControl], ntfQueue[NtfLaneControl].count);
+	ntfStarve = 0u;
+	stackBusy = 0u;
+}
+
+/*******************************************************************************
+ * Function Name: notificationPending
+ ********************************************************************************
+ * Summary:
+ *    This function returns the number of queued frames that can be sent now.
+ *    Frames stored for a later connection or waiting for credits do not keep
+ *    the CPU awake.
+ *
+ * Parameters:
+ *  void
+ *
+ * Return:
+ *  uint8: queue depth
+ *
+ *******************************************************************************/
+uint8 notificationPending(void)
+{
+	if (0u == ntfCredits)
+	{
+		return 0u;
+	}
+#ifdef STORE_AND_FORWARD
+	if ((CYBLE_STATE_CONNECTED != cyBle_state) || (0u == sendNotifications))
+	{
+		return 0u;
+	}
+#endif /* STORE_AND_FORWARD */
+	return notificationQueued();
+}
+
+/*******************************************************************************
+ * Function Name: notificationQueued
+ ********************************************************************************
+ * Summary:
+ *    This function returns the number of queued frames of both lanes,
+ *    including the ones stored for a later connection
+ *
+ * Parameters:
+ *  void
+ *
+ * Return:
+ *  uint8: queue depth
+ *
+ *******************************************************************************/
+uint8 notificationQueued(void)
+{
+	return ntfQueue[NtfLaneControl].count + ntfQueue[NtfLaneBulk].count;
+}
+
+/*******************************************************************************
+ * Function Name: notificationFree
+ ********************************************************************************
+ * Summary:
+ *    This function returns the number of bulk frames the queue takes before
+ *    it drops one
+ *
+ * Parameters:
+ *  void
+ *
+ * Return:
+ *  uint8: free bulk slots
+ *
+ *******************************************************************************/
+uint8 notificationFree(void)
+{
+	return NTF_QUEUE_DEPTH - ntfQueue[NtfLaneBulk].count;
+}
+
+/*******************************************************************************
+ * Function Name: notifyStackBusy
+ ********************************************************************************
+ * Summary:
+ *    This function records the stack busy status, call on
+ *    CYBLE_EVT_STACK_BUSY_STATUS
+ *
+ * Parameters:
+ *  busy:	CYBLE_STACK_STATE_BUSY or CYBLE_STACK_STATE_FREE
+ *
+ * Return:
+ *  void
+ *
+ *******************************************************************************/
+void notifyStackBusy(uint8 busy)
+{
+	stackBusy = (CYBLE_STACK_STATE_BUSY == busy);
+	if (0u != stackBusy)
+	{
+		ntfStats.busy++;
+	}
+}
+
+/*******************************************************************************
+ * Function Name: notifyMtuExchanged
+ ********************************************************************************
+ * Summary:
+ *    This function records the ATT MTU of the connection. Call on
+ *    CYBLE_EVT_GATTS_XCNHG_MTU_REQ with the MTU asked by the Client, the BLE
+ *    component answers with CYBLE_GATT_MTU and the smaller one is used.
+ *    Call with CYBLE_GATT_DEFAULT_MTU on disconnect.
+ *
+ * Parameters:
+ *  mtu:	ATT MTU
+ *
+ * Return:
+ *  void
+ *
+ *******************************************************************************/
+void notifyMtuExchanged(uint16 mtu)
+{
+	ntfMtu = (mtu < CYBLE_GATT_MTU) ? mtu : CYBLE_GATT_MTU;
+	if (ntfMtu < CYBLE_GATT_DEFAULT_MTU)
+	{
+		ntfMtu = CYBLE_GATT_DEFAULT_MTU;
+	}
+}
+
+/*******************************************************************************
+ * Function Name: notificationPayloadMax
+ ********************************************************************************
+ * Summary:
+ *    This function returns the largest notification value for the current
+ *    ATT MTU
+ *
+ * Parameters:
+ *  void
+ *
+ * Return:
+ *  uint16: ATT MTU - 3
+ *
+ *******************************************************************************/
+uint16 notificationPayloadMax(void)
+{
+	return ntfMtu - 3u;
+}
+
+/*******************************************************************************
+ * Function Name: notifyCredits
+ ********************************************************************************
+ * Summary:
+ *    This function lets the given number of frames more go out, call when the
+ *    phone writes a credit. The first credit turns on the pacing.
+ *
+ * Parameters:
+ *  credits:	frames the phone is ready to take
+ *
+ * Return:
+ *  void
+ *
+ *******************************************************************************/
+void notifyCredits(uint8 credits)
+{
+	if (NTF_CREDITS_UNLIMITED == ntfCredits)
+	{
+		ntfCredits = 0u;
+	}
+
+	ntfCredits = ((NTF_CREDITS_MAX - ntfCredits) > credits) ? (ntfCredits + credits) : NTF_CREDITS_MAX;
+	ntfStats.credited += credits;
+}
+
+/*******************************************************************************
+ * Function Name: notifyCreditReset
+ ********************************************************************************
+ * Summary:
+ *    This function stops the pacing until the phone writes a credit again,
+ *    call on disconnect
+ *
+ * Parameters:
+ *  void
+ *
+ * Return:
+ *  void
+ *
+ *******************************************************************************/
+void notifyCreditReset(void)
+{
+	ntfCredits = NTF_CREDITS_UNLIMITED;
+}
+
+/*******************************************************************************
+ * Function Name: notificationCredits
+ ********************************************************************************
+ * Summary:
+ *    This function returns the frames the phone still takes
+ *
+ * Parameters:
+ *  void
+ *
+ * Return:
+ *  uint16: credits, NTF_CREDITS_UNLIMITED if the phone does not pace
+ *
+ *******************************************************************************/
+uint16 notificationCredits(void)
+{
+	return ntfCredits;
+}
@@ -0,0 +1,116 @@
+/*
+ * Copyright (C) 2022 teamprof.net@gmail.com or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#pragma once
+#include "main.h"
+
+#ifdef STORE_AND_FORWARD
+#define NTF_QUEUE_DEPTH 16u /* notifications waiting for the BLE stack or a connection */
+#define NTF_STORE_AGE_MS 5000u /* frames older than this are never sent, below 131000 */
+#else
+#define NTF_QUEUE_DEPTH 8u /* notifications waiting for the BLE stack */
+#endif /* STORE_AND_FORWARD */
+
+/* Frames are queued by lane. Control frames (launch requests and the other
+   launcher messages) go out ahead of bulk frames (trackpad stream), but after
+   NTF_STARVE_MAX control notifications in a row one bulk notification gets
+   through. The control lane is small, a control frame that finds it full
+   is queued as a bulk frame. */
+typedef enum
+{
+	NtfLaneControl,
+	NtfLaneBulk,
+	NtfLaneCount
+} NTF_LANE_T;
+
+#define NTF_CONTROL_DEPTH 4u
+#define NTF_STARVE_MAX 4u
+
+/* Frame slots: the lanes, the writes the main loop has not taken yet and the
+   active I2C write buffer. A burst of writes may take every free slot, the
+   I2C_WRITE_DEPTH slots are left for it even when both lanes are full. */
+#define NTF_SLOT_COUNT (NTF_QUEUE_DEPTH + NTF_CONTROL_DEPTH + I2C_WRITE_DEPTH + 1u)
+#define NTF_SLOT_NONE 0xFFu /* no free frame slot, see notificationSlotAlloc() */
+
+/* What to do when a frame arrives and the queue is full */
+#define NTF_DROP_OLDEST 0u
+#define NTF_DROP_NEWEST 1u
+#define NTF_QUEUE_POLICY NTF_DROP_OLDEST
+
+/* With NOTIFY_PACKING every notification carries one or more records of
+   [length][frame], as many queued frames as fit in ATT MTU - 3 bytes */
+#ifdef NOTIFY_PACKING
+#define NTF_RECORD_HEADER 1u
+#else
+#define NTF_RECORD_HEADER 0u
+#endif /* NOTIFY_PACKING */
+
+#define NTF_PAYLOAD_SIZE_MAX (CYBLE_GATT_MTU - 3u) /* largest notification value */
+
+/* With CREDIT_FLOW the phone paces the notifications: every credit it writes
+   to the RX characteristic lets one more frame go out, frames without credit
+   stay queued and the launcher sees the queue fill up. A phone that never
+   writes a credit is not paced, the credits start over on every connection. */
+#define NTF_CREDITS_UNLIMITED 0xFFFFu
+#define NTF_CREDITS_MAX 0xFFFEu
+
+typedef struct
+{
+	uint32 sent;	   /* frames accepted by the stack */
+	uint32 dropped;	   /* frames lost to a full queue or rejected by the stack */
+	uint64 latencySum; /* I2C write to notification (APP_TIMER_HZ), 64 bit so it never wraps */
+	uint32 latencyMax; /* longest I2C write to notification (APP_TIMER_HZ) */
+} NTF_LANE_STATS_T;
+
+typedef struct
+{
+	uint32 queued;	   /* frames accepted by the queue */
+	uint32 sent;	   /* frames accepted by the stack */
+	uint32 packets;	   /* notifications accepted by the stack */
+	uint32 retries;	   /* notification refused for lack of stack buffers */
+	uint32 busy;	   /* CYBLE_EVT_STACK_BUSY_STATUS reported busy */
+	uint32 dropped;	   /* frames lost to a full queue or rejected by the stack */
+	uint32 oversize;   /* frames larger than the ATT MTU */
+	uint32 expired;	   /* frames older than NTF_STORE_AGE_MS */
+	uint32 credited;   /* frames credited by the phone */
+	uint64 latencySum; /* I2C write to notification, all sent frames (APP_TIMER_HZ), 64 bit */
+	uint32 latencyMin; /* shortest I2C write to notification (APP_TIMER_HZ) */
+	uint32 latencyMax; /* longest I2C write to notification (APP_TIMER_HZ) */
+	uint8 highWater;   /* largest queue depth seen */
+	NTF_LANE_STATS_T lane[NtfLaneCount];
+} NTF_STATS_T;
+
+extern NTF_STATS_T ntfStats;
+
+extern uint8 notificationSlotAlloc(void);
+extern void notificationSlotFree(uint8 slot);
+extern uint8 *notificationSlotBuffer(uint8 slot);
+extern uint8 commitNotification(uint8 slot, uint8 len, uint8 lane, uint32 time);
+extern void handleNotificationQueue(void);
+extern void clearNotificationQueue(void);
+extern uint8 notificationPending(void);
+extern uint8 notificationQueued(void);
+extern uint8 notificationFree(void);
+extern void notifyStackBusy(uint8 busy);
+extern void notifyMtuExchanged(uint16 mtu);
+extern uint16 notificationPayloadMax(void);
+extern void notifyCredits(uint8 credits);
+extern void notifyCreditReset(void);
+extern uint16 notificationCredits(void);
@@ -0,0 +1,319 @@
+/*
+ * Copyright (C) 2022 teamprof.net@gmail.com or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include <string.h>
+#include "app_Rx.h"
+
+RX_STATS_T rxStats;
+
+static uint8 rxBlob[RX_BLOB_SIZE];
+static uint16 rxBlobLen;		/* length of the blob being read by the master */
+static uint16 rxReadOffset;		/* offset of the chunk in the read buffer */
+static uint8 rxReadLen;			/* data bytes of the chunk in the read buffer */
+static uint8 rxReading;			/* blob chunks are being read */
+static uint16 rxStreamLen;		/* bytes of the stream received so far */
+static uint8 rxStreamSequence;	/* sequence of the next chunk */
+static uint8 rxStreaming;		/* stream blob in progress */
+
+/*******************************************************************************
+ * Function Name: publishChunk
+ ********************************************************************************
+ * Summary:
+ *    This function puts the chunk at rxReadOffset in the I2C read buffer
+ *
+ * Parameters:
+ *  void
+ *
+ * Return:
+ *  void
+ *
+ *******************************************************************************/
+static void publishChunk(void)
+{
+	uint8 chunk[I2C_READ_BUFFER_SIZE];
+	uint16 left = rxBlobLen - rxReadOffset;
+
+	rxReadLen = (left > RX_CHUNK_DATA) ? RX_CHUNK_DATA : (uint8)left;
+
+	chunk[0] = RX_CHUNK_TAG | ((0u == rxReadOffset) ? RX_CHUNK_FIRST : 0u) | ((rxReadLen == left) ? RX_CHUNK_LAST : 0u);
+	chunk[1] = LO8(rxReadOffset);
+	chunk[2] = HI8(rxReadOffset);
+	chunk[3] = rxReadLen;
+	memcpy(&chunk[RX_CHUNK_HEADER], &rxBlob[rxReadOffset], rxReadLen);
+
+	updateI2CReadData(chunk, RX_CHUNK_HEADER + rxReadLen);
+}
+
+/*******************************************************************************
+ * Function Name: rxWrite
+ ********************************************************************************
+ * Summary:
+ *    This function publishes a single write to the RX characteristic to the
+ *    I2C read buffer, a blob still being read is given up. Credits are taken
+ *    by the notification queue.
+ *
+ * Parameters:
+ *  data:	value written by the Client
+ *  len:	number of bytes
+ *
+ * Return:
+ *  void
+ *
+ *******************************************************************************/
+void rxWrite(const uint8 *data, uint16 len)
+{
+#ifdef CREDIT_FLOW
+	if ((RX_CREDIT_SIZE == len) && (RX_CREDIT_TAG == data[0]))
+	{
+		notifyCredits(data[1]);
+		return;
+	}
+#endif /* CREDIT_FLOW */
+
+	rxReading = 0u;
+	updateI2CReadData(data, len);
+}
+
+/*******************************************************************************
+ * Function Name: rxPrepareWrite
+ ********************************************************************************
+ * Summary:
+ *    This function tells if a long write to an attribute is accepted, call on
+ *    CYBLE_EVT_GATTS_PREP_WRITE_REQ. The answer must be given inside the BLE
+ *    stack callback.
+ *
+ * Parameters:
+ *  attrHandle:	attribute of the prepared write
+ *
+ * Return:
+ *  uint8: CYBLE_GATTS_PREP_WRITE_SUPPORT or CYBLE_GATTS_PREP_WRITE_NOT_SUPPORT
+ *
+ *******************************************************************************/
+uint8 rxPrepareWrite(CYBLE_GATT_DB_ATTR_HANDLE_T attrHandle)
+{
+	return (CYBLE_VOICE_ASSISTANT_LAUNCHER_RXCHARACTERISTIC_CHAR_HANDLE == attrHandle) ? CYBLE_GATTS_PREP_WRITE_SUPPORT : CYBLE_GATTS_PREP_WRITE_NOT_SUPPORT;
+}
+
+/*******************************************************************************
+ * Function Name: rxExecuteWrite
+ ********************************************************************************
+ * Summary:
+ *    This function collects the parts of an executed long write to the RX
+ *    characteristic in the receive buffer, call on
+ *    CYBLE_EVT_GATTS_EXEC_WRITE_REQ. The parts are only valid inside the BLE
+ *    stack callback, rxBlobReady() hands the blob to the master later.
+ *
+ * Parameters:
+ *  execWrite:	prepared parts
+ *
+ * Return:
+ *  uint16: blob length, 0 if there is none
+ *
+ *******************************************************************************/
+uint16 rxExecuteWrite(const CYBLE_GATTS_EXEC_WRITE_REQ_T *execWrite)
+{
+	const CYBLE_GATT_HANDLE_VALUE_OFFSET_PARAM_T *part;
+	uint16 len = 0u;
+	uint16 partLen;
+	uint8 i;
+
+	if ((CYBLE_GATT_EXECUTE_WRITE_EXEC_FLAG != execWrite->execWriteFlag) || (0u != execWrite->gattErrorCode))
+	{
+		return 0u;
+	}
+
+	/* The buffer is rewritten, stop handing out the old blob */
+	rxReading = 0u;
+
+	for (i = 0; i < execWrite->prepWriteReqCount; i++)
+	{
+		part = &execWrite->baseAddr[i];
+		if (CYBLE_VOICE_ASSISTANT_LAUNCHER_RXCHARACTERISTIC_CHAR_HANDLE != part->handleValuePair.attrHandle)
+		{
+			continue;
+		}
+
+		partLen = part->handleValuePair.value.len;
+		if (part->offset >= RX_BLOB_SIZE)
+		{
+			rxStats.overflow++;
+			continue;
+		}
+		if ((part->offset + partLen) > RX_BLOB_SIZE)
+		{
+			rxStats.overflow++;
+			partLen = RX_BLOB_SIZE - part->offset;
+		}
+
+		memcpy(&rxBlob[part->offset], part->handleValuePair.value.val, partLen);
+		if ((part->offset + partLen) > len)
+		{
+			len = part->offset + partLen;
+		}
+	}
+
+	if (0u != len)
+	{
+		rxStats.longWrites++;
+	}
+	return len;
+}
+
+/*******************************************************************************
+ * Function Name: rxStreamWrite
+ ********************************************************************************
+ * Summary:
+ *    This function appends a chunk written to the RX Stream characteristic to
+ *    the receive buffer. The chunk flagged RX_STREAM_LAST completes the blob,
+ *    a missing chunk drops it.
+ *
+ * Parameters:
+ *  data:	[flags | sequence] chunk
+ *  len:	number of bytes
+ *
+ * Return:
+ *  void
+ *
+ *******************************************************************************/
+void rxStreamWrite(const uint8 *data, uint16 len)
+{
+	uint16 chunkLen;
+
+	if (0u == len)
+	{
+		return;
+	}
+	rxStats.streamChunks++;
+
+	if (0u != (data[0] & RX_STREAM_FIRST))
+	{
+		rxReading = 0u;
+		rxStreaming = 1u;
+		rxStreamLen = 0u;
+	}
+	else if ((0u == rxStreaming) || ((data[0] & RX_STREAM_SEQUENCE) != rxStreamSequence))
+	{
+		if (0u != rxStreaming)
+		{
+			rxStats.gaps++;
+			rxStreaming = 0u;
+		}
+		return;
+	}
+	rxStreamSequence = (data[0] + 1u) & RX_STREAM_SEQUENCE;
+
+	chunkLen = len - 1u;
+	if ((rxStreamLen + chunkLen) > RX_BLOB_SIZE)
+	{
+		rxStats.overflow++;
+		chunkLen = RX_BLOB_SIZE - rxStreamLen;
+	}
+	memcpy(&rxBlob[rxStreamLen], &data[1], chunkLen);
+	rxStreamLen += chunkLen;
+
+	if (0u != (data[0] & RX_STREAM_LAST))
+	{
+		rxStreaming = 0u;
+		rxBlobReady(rxStreamLen);
+	}
+}
+
+/*******************************************************************************
+ * Function Name: rxBlobReady
+ ********************************************************************************
+ * Summary:
+ *    This function puts the first chunk of a complete blob in the I2C read
+ *    buffer
+ *
+ * Parameters:
+ *  len:	blob length
+ *
+ * Return:
+ *  void
+ *
+ *******************************************************************************/
+void rxBlobReady(uint16 len)
+{
+	if (0u == len)
+	{
+		return;
+	}
+
+	if (0u != rxReading)
+	{
+		rxStats.replaced++;
+	}
+	rxStats.blobs++;
+
+	rxBlobLen = len;
+	rxReadOffset = 0u;
+	rxReading = 1u;
+	publishChunk();
+}
+
+/*******************************************************************************
+ * Function Name: rxChunkRead
+ ********************************************************************************
+ * Summary:
+ *    This function moves on to the next chunk once the master read the
+ *    current one, call when a master read completed. The last chunk stays in
+ *    the read buffer.
+ *
+ * Parameters:
+ *  void
+ *
+ * Return:
+ *  void
+ *
+ *******************************************************************************/
+void rxChunkRead(void)
+{
+	if (0u == rxReading)
+	{
+		return;
+	}
+	rxStats.chunks++;
+
+	rxReadOffset += rxReadLen;
+	if (rxReadOffset >= rxBlobLen)
+	{
+		rxReading = 0u;
+		return;
+	}
+	publishChunk();
+}
+
+/*******************************************************************************
+ * Function Name: rxBlobLeft
+ ********************************************************************************
+ * Summary:
+ *    This function returns the blob bytes the master has not read yet
+ *
+ * Parameters:
+ *  void
+ *
+ * Return:
+ *  uint16: bytes left, 0 if no blob is being read
+ *
+ *******************************************************************************/
+uint16 rxBlobLeft(void)
+{
+	return (0u != rxReading) ? (uint16)(rxBlobLen - rxReadOffset) : 0u;
+}
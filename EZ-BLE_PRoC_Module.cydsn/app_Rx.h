@@ -0,0 +1,71 @@
+/*
+ * Copyright (C) 2022 teamprof.net@gmail.com or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#pragma once
+#include "main.h"
+
+/* Blobs larger than one write (gesture maps, templates) are collected in a
+   receive buffer and read by the I2C master in chunks. A blob is written
+   either as a long write to the RX characteristic (prepare/execute, its
+   value is RX_BLOB_SIZE bytes long in the BLE component, which also sizes
+   the prepare write queue), or as Write Without Response chunks of up to
+   ATT MTU - 3 bytes to the RX Stream characteristic, each chunk prefixed by
+   [RX_STREAM_FIRST | RX_STREAM_LAST | sequence]. Single writes to RX are
+   published to the read buffer as before. */
+#define RX_BLOB_SIZE 512u
+
+#define RX_STREAM_FIRST 0x80u	/* first chunk of a blob */
+#define RX_STREAM_LAST 0x40u	/* last chunk of a blob */
+#define RX_STREAM_SEQUENCE 0x3Fu /* chunk counter, a gap drops the blob */
+
+/* Every master read of a blob returns [flags][offset:2][length][data], the
+   next read the following chunk, until the chunk flagged RX_CHUNK_LAST. The
+   flags carry RX_CHUNK_TAG, a launcher message never starts with it. */
+#define RX_CHUNK_TAG 0xC0u
+#define RX_CHUNK_FIRST 0x01u
+#define RX_CHUNK_LAST 0x02u
+#define RX_CHUNK_HEADER 4u
+#define RX_CHUNK_DATA (I2C_READ_BUFFER_SIZE - RX_CHUNK_HEADER)
+
+/* With CREDIT_FLOW a write of [RX_CREDIT_TAG][frames] to RX returns
+   notification credits, it is not published to the I2C master */
+#define RX_CREDIT_TAG 0xC8u
+#define RX_CREDIT_SIZE 2u
+
+typedef struct
+{
+	uint32 blobs;		 /* blobs handed to the I2C master */
+	uint32 longWrites;	 /* executed long writes */
+	uint32 streamChunks; /* RX Stream writes */
+	uint32 gaps;		 /* blobs dropped for a missing stream chunk */
+	uint32 overflow;	 /* blobs cut to RX_BLOB_SIZE */
+	uint32 chunks;		 /* chunks read by the I2C master */
+	uint32 replaced;	 /* blobs replaced before the master read them all */
+} RX_STATS_T;
+
+extern RX_STATS_T rxStats;
+
+extern void rxWrite(const uint8 *data, uint16 len);
+extern uint8 rxPrepareWrite(CYBLE_GATT_DB_ATTR_HANDLE_T attrHandle);
+extern uint16 rxExecuteWrite(const CYBLE_GATTS_EXEC_WRITE_REQ_T *execWrite);
+extern void rxStreamWrite(const uint8 *data, uint16 len);
+extern void rxBlobReady(uint16 len);
+extern void rxChunkRead(void);
+extern uint16 rxBlobLeft(void);
@@ -0,0 +1,175 @@
+/*
+ * Copyright (C) 2022 teamprof.net@gmail.com or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include "app_Telemetry.h"
+
+static uint8 telemetryNotify; /* Client enabled telemetry notifications */
+static uint32 telemetryTime;  /* time stamp of the last refresh */
+
+/*******************************************************************************
+ * Function Name: latencyMs
+ ********************************************************************************
+ * Summary:
+ *    This function converts a latency to the milliseconds of the record, a
+ *    frame held longer than 65 s reads as 0xFFFF
+ *
+ * Parameters:
+ *  ticks:	latency (APP_TIMER_HZ)
+ *
+ * Return:
+ *  uint16: latency in ms
+ *
+ *******************************************************************************/
+static uint16 latencyMs(uint32 ticks)
+{
+	return (ticks < APP_TIMER_MS(0xFFFFu)) ? (uint16)APP_TIMER_TO_MS(ticks) : 0xFFFFu;
+}
+
+/*******************************************************************************
+ * Function Name: laneLatencyAvg
+ ********************************************************************************
+ * Summary:
+ *    This function returns the average latency of one notification lane
+ *
+ * Parameters:
+ *  lane:	lane statistics
+ *
+ * Return:
+ *  uint16: average I2C write to notification in ms, 0 before the first frame
+ *
+ *******************************************************************************/
+static uint16 laneLatencyAvg(const NTF_LANE_STATS_T *lane)
+{
+	return (0u != lane->sent) ? latencyMs((uint32)(lane->latencySum / lane->sent)) : 0u;
+}
+
+/*******************************************************************************
+ * Function Name: telemetryRecord
+ ********************************************************************************
+ * Summary:
+ *    This function collects the counters of the bridge modules into one
+ *    record. The modules only count on their hot paths, all the copying and
+ *    dividing is done here.
+ *
+ * Parameters:
+ *  record:	filled with the current counters
+ *
+ * Return:
+ *  void
+ *
+ *******************************************************************************/
+void telemetryRecord(TELEMETRY_RECORD_T *record)
+{
+	record->version = TELEMETRY_VERSION;
+	record->ntfHighWater = ntfStats.highWater;
+	record->eventHighWater = eventStats.highWater;
+	record->reserved = 0u;
+	record->i2cFrames = i2cStats.frames;
+	record->ntfSent = ntfStats.sent;
+	record->ntfRetries = ntfStats.retries;
+	record->ntfBusy = ntfStats.busy;
+	record->ntfDropped = ntfStats.dropped;
+	record->deepSleeps = powerStats.entries[PowerDeepSleep];
+	record->deepSleepMs = powerStats.residencyMs[PowerDeepSleep];
+	record->activeMs = powerStats.residencyMs[PowerActive] + powerStats.residencyMs[PowerSleep];
+	record->connects = (uint16)bondStats.connects;
+
+	if (0u != ntfStats.sent)
+	{
+		record->latencyMin = latencyMs(ntfStats.latencyMin);
+		record->latencyAvg = latencyMs((uint32)(ntfStats.latencySum / ntfStats.sent));
+		record->latencyMax = latencyMs(ntfStats.latencyMax);
+	}
+	else
+	{
+		record->latencyMin = 0u;
+		record->latencyAvg = 0u;
+		record->latencyMax = 0u;
+	}
+
+	record->controlLatencyAvg = laneLatencyAvg(&ntfStats.lane[NtfLaneControl]);
+	record->controlLatencyMax = latencyMs(ntfStats.lane[NtfLaneControl].latencyMax);
+	record->bulkLatencyAvg = laneLatencyAvg(&ntfStats.lane[NtfLaneBulk]);
+	record->bulkLatencyMax = latencyMs(ntfStats.lane[NtfLaneBulk].latencyMax);
+}
+
+/*******************************************************************************
+ * Function Name: telemetryEnable
+ ********************************************************************************
+ * Summary:
+ *    This function records the telemetry CCCD, a new subscriber gets a record
+ *    on the next call to handleTelemetry()
+ *
+ * Parameters:
+ *  enable:	non-zero if notifications are enabled
+ *
+ * Return:
+ *  void
+ *
+ *******************************************************************************/
+void telemetryEnable(uint8 enable)
+{
+	telemetryNotify = enable;
+	telemetryTime = appTimerNow() - APP_TIMER_MS(TELEMETRY_PERIOD_MS);
+}
+
+/*******************************************************************************
+ * Function Name: handleTelemetry
+ ********************************************************************************
+ * Summary:
+ *    This function refreshes the Telemetry characteristic every
+ *    TELEMETRY_PERIOD_MS while connected and notifies it when enabled. A
+ *    notification the stack has no buffer for is skipped, not retried.
+ *
+ * Parameters:
+ *  void
+ *
+ * Return:
+ *  void
+ *
+ *******************************************************************************/
+void handleTelemetry(void)
+{
+#ifdef TELEMETRY_ENABLED
+	TELEMETRY_RECORD_T record;
+	CYBLE_GATT_HANDLE_VALUE_PAIR_T telemetryHandle;
+
+	if ((CYBLE_STATE_CONNECTED != cyBle_state) ||
+		(appTimerElapsed(telemetryTime) < APP_TIMER_MS(TELEMETRY_PERIOD_MS)))
+	{
+		return;
+	}
+	telemetryTime = appTimerNow();
+
+	telemetryRecord(&record);
+
+	telemetryHandle.attrHandle = CYBLE_VOICE_ASSISTANT_LAUNCHER_TELEMETRY_CHAR_HANDLE;
+	telemetryHandle.value.val = (uint8 *)&record;
+	telemetryHandle.value.len = sizeof(record);
+
+	/* Value returned to reads */
+	CyBle_GattsWriteAttributeValue(&telemetryHandle, 0, &cyBle_connHandle, CYBLE_GATT_DB_LOCALLY_INITIATED);
+
+	if ((0u != telemetryNotify) && (sizeof(record) <= notificationPayloadMax()))
+	{
+		(void)CyBle_GattsNotification(cyBle_connHandle, &telemetryHandle);
+	}
+#endif /* TELEMETRY_ENABLED */
+}
@@ -0,0 +1,61 @@
+/*
+ * Copyright (C) 2022 teamprof.net@gmail.com or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#pragma once
+#include "main.h"
+
+/* The Telemetry characteristic (read, notify, 52 bytes) belongs to the Voice
+   Assistant Launcher service of the BLE component, its length must follow
+   TELEMETRY_RECORD_T. The code is only built once its handle is generated. */
+#ifdef CYBLE_VOICE_ASSISTANT_LAUNCHER_TELEMETRY_CHAR_HANDLE
+#define TELEMETRY_ENABLED
+#endif
+
+#define TELEMETRY_VERSION 3u
+#define TELEMETRY_PERIOD_MS 5000u /* characteristic value refresh while connected */
+
+/* Telemetry record, little endian, times in APP_TIMER_HZ ticks unless noted */
+CYPACKED typedef struct
+{
+	uint8 version;		   /* TELEMETRY_VERSION */
+	uint8 ntfHighWater;	   /* notification queue */
+	uint8 eventHighWater;  /* BLE event queue */
+	uint8 reserved;
+	uint32 i2cFrames;	   /* writes completed by the launcher */
+	uint32 ntfSent;		   /* frames notified */
+	uint32 ntfRetries;	   /* notifications refused for lack of stack buffers */
+	uint32 ntfBusy;		   /* stack busy events */
+	uint32 ntfDropped;	   /* frames lost */
+	uint32 deepSleeps;	   /* deep sleep entries */
+	uint32 deepSleepMs;	   /* time in deep sleep (ms) */
+	uint32 activeMs;	   /* time awake (ms) */
+	uint16 connects;	   /* connections since reset */
+	uint16 latencyMin;	   /* I2C write to notification (ms), version 3 */
+	uint16 latencyAvg;
+	uint16 latencyMax;
+	uint16 controlLatencyAvg; /* per lane, version 2 */
+	uint16 controlLatencyMax;
+	uint16 bulkLatencyAvg;
+	uint16 bulkLatencyMax;
+} CYPACKED_ATTR TELEMETRY_RECORD_T;
+
+extern void telemetryRecord(TELEMETRY_RECORD_T *record);
+extern void telemetryEnable(uint8 enable);
+extern void handleTelemetry(void);
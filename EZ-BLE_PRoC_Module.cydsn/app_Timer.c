@@ -0,0 +1,105 @@
+/*
+ * Copyright (C) 2022 teamprof.net@gmail.com or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include "app_Timer.h"
+
+/*******************************************************************************
+ * Function Name: appTimerStart
+ ********************************************************************************
+ * Summary:
+ *    This function starts the free running WDT counter used as time base
+ *
+ * Parameters:
+ *  void
+ *
+ * Return:
+ *  void
+ *
+ *******************************************************************************/
+void appTimerStart(void)
+{
+	CySysWdtUnlock();
+
+	/* Free running 32 bit counter without interrupt. Counter 2 has no match
+	register, so there is no clear on match to turn off, and the toggle bit
+	only selects its interrupt period. */
+	CySysWdtWriteMode(APP_TIMER_COUNTER, CY_SYS_WDT_MODE_NONE);
+
+	CySysWdtEnable(APP_TIMER_COUNTER_MASK);
+
+	CySysWdtLock();
+}
+
+/*******************************************************************************
+ * Function Name: appTimerNow
+ ********************************************************************************
+ * Summary:
+ *    This function returns the current time base value
+ *
+ * Parameters:
+ *  void
+ *
+ * Return:
+ *  uint32: timer ticks (APP_TIMER_HZ), wraps around
+ *
+ *******************************************************************************/
+uint32 appTimerNow(void)
+{
+	return CySysWdtReadCount(APP_TIMER_COUNTER);
+}
+
+/*******************************************************************************
+ * Function Name: appTimerElapsed
+ ********************************************************************************
+ * Summary:
+ *    This function returns the number of ticks passed since a time stamp
+ *
+ * Parameters:
+ *  since: time stamp returned by appTimerNow()
+ *
+ * Return:
+ *  uint32: elapsed ticks
+ *
+ *******************************************************************************/
+uint32 appTimerElapsed(uint32 since)
+{
+	return appTimerNow() - since;
+}
+
+/*******************************************************************************
+ * Function Name: appTimerElapsedMs
+ ********************************************************************************
+ * Summary:
+ *    This function returns the number of milliseconds passed since a time
+ *    stamp, it does not overflow for long intervals like APP_TIMER_TO_MS
+ *
+ * Parameters:
+ *  since: time stamp returned by appTimerNow()
+ *
+ * Return:
+ *  uint32: elapsed milliseconds
+ *
+ *******************************************************************************/
+uint32 appTimerElapsedMs(uint32 since)
+{
+	uint32 ticks = appTimerElapsed(since);
+
+	return ((ticks / APP_TIMER_HZ) * 1000u) + APP_TIMER_TO_MS(ticks % APP_TIMER_HZ);
+}
@@ -0,0 +1,36 @@
+/*
+ * Copyright (C) 2022 teamprof.net@gmail.com or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#pragma once
+#include "main.h"
+
+/* WDT counter 2 free-runs from LFCLK (WCO) and keeps counting in deep sleep */
+#define APP_TIMER_COUNTER CY_SYS_WDT_COUNTER2
+#define APP_TIMER_COUNTER_MASK CY_SYS_WDT_COUNTER2_MASK
+#define APP_TIMER_HZ 32768u
+
+/* Convert between milliseconds and timer ticks (only for short intervals) */
+#define APP_TIMER_MS(ms) ((uint32)(((uint32)(ms) * APP_TIMER_HZ) / 1000u))
+#define APP_TIMER_TO_MS(ticks) ((uint32)(((uint32)(ticks) * 1000u) / APP_TIMER_HZ))
+
+extern void appTimerStart(void);
+extern uint32 appTimerNow(void);
+extern uint32 appTimerElapsed(uint32 since);
+extern uint32 appTimerElapsedMs(uint32 since);
@@ -16,5 +16,10 @@
 
 #define LOW_POWER_MODE
 #define LED_INDICATION	
+#define LINK_WARM_UP
+#define NOTIFY_PACKING
+#define STORE_AND_FORWARD
+#define ADV_BROADCAST
+#define CREDIT_FLOW
 
 #endif	/* _CONFIG_H_ */
@@ -14,6 +14,10 @@
     
     /*Define your macro callbacks here */
     /*For more information, refer to the Writing Code topic in the PSoC Creator Help.*/
+
+    /* I2C slave completions are posted to the main loop, see app_I2C.c */
+    #define I2C_I2C_ISR_EXIT_CALLBACK
+    void I2C_I2C_ISR_ExitCallback(void);
     
 #endif /* CYAPICALLBACKS_H */   
 /* [] */
@@ -11,15 +11,95 @@
 */
 
 #include "low_power.h"
+#include "app_Event.h"
+
+POWER_STATS_T powerStats;
+
+static uint8 powerVotes[PowerVoteCount] = {PowerDeepSleep, PowerDeepSleep, PowerDeepSleep};
+
+/*******************************************************************************
+* Function Name: powerVote
+********************************************************************************
+* Summary:
+*        This function records the deepest power state a source can tolerate
+*	     
+* Parameters:
+*	source:		POWER_VOTE_T
+*	deepest:	POWER_STATE_T
+*
+* Return:
+*  	void
+*
+*******************************************************************************/
+void powerVote(uint8 source, uint8 deepest)
+{
+    powerVotes[source] = deepest;
+}
+
+/*******************************************************************************
+* Function Name: powerAllowed
+********************************************************************************
+* Summary:
+*        This function returns the deepest power state all sources tolerate
+*	     
+* Parameters:
+*	void
+*
+* Return:
+*  	uint8: POWER_STATE_T
+*
+*******************************************************************************/
+uint8 powerAllowed(void)
+{
+    uint8 allowed = PowerDeepSleep;
+    uint8 i;
+    
+    for(i = 0; i < PowerVoteCount; i++)
+    {
+        if(powerVotes[i] < allowed)
+        {
+            allowed = powerVotes[i];
+        }
+    }
+    return allowed;
+}
 
 #ifdef LOW_POWER_MODE
+
+static uint32 powerSince;                       /* time stamp of the last state change */
+static uint32 powerCarry[PowerStateCount];      /* ticks not accounted as whole milliseconds yet */
+
+/*******************************************************************************
+* Function Name: powerAccount
+********************************************************************************
+* Summary:
+*        This function adds the time since the last state change to a state
+*	     
+* Parameters:
+*	state:	POWER_STATE_T
+*
+* Return:
+*  	void
+*
+*******************************************************************************/
+static void powerAccount(uint8 state)
+{
+    uint32 start = powerSince - powerCarry[state];
+    uint32 ms = appTimerElapsedMs(start);   /* deep sleep easily outlasts APP_TIMER_TO_MS */
+    
+    powerStats.residencyMs[state] += ms;
+    powerSince = appTimerNow();
+    powerCarry[state] = powerSince - (start + ((ms / 1000u) * APP_TIMER_HZ) + APP_TIMER_MS(ms % 1000u));
+}
 	
 /*******************************************************************************
 * Function Name: handleLowPowerMode
 ********************************************************************************
 * Summary:
-*        This functions puts the BLESS and the MCU core to the lowest possible
-*		power state
+*        This functions puts the BLESS and the MCU core to the deepest power
+*		state all sources allow. An I2C transfer in progress only keeps the
+*		CPU out of deep sleep, it sleeps until the I2C interrupt instead of
+*		spinning. An idle I2C slave wakes the chip on its address.
 *	     
 * Parameters:
 *	void
@@ -28,74 +108,95 @@
 *  	void
 *
 *******************************************************************************/
-	
 void handleLowPowerMode(void)
 {
 	CYBLE_LP_MODE_T lpMode;
     CYBLE_BLESS_STATE_T blessState;
     uint8 interruptStatus;
+    uint8 allowed;
+    uint8 state = PowerActive;
 	
 	if(CyBle_GetState() != CYBLE_STATE_INITIALIZING)
     {
-		while((I2C_I2CSlaveStatus() & (I2C_I2C_SSTAT_RD_BUSY | I2C_I2C_SSTAT_WR_BUSY)))
-		{
-			/* Wait till I2C read/write to complete */
-		}
+        /* Notifications the stack could not take yet are sent on the next BLE event */
+        powerVote(PowerVoteNotify, (notificationPending() != 0u) ? PowerSleep : PowerDeepSleep);
+        
         /* Put BLE sub system in DeepSleep mode when it is idle */
         lpMode = CyBle_EnterLPM(CYBLE_BLESS_DEEPSLEEP);
         
        /* Disable global interrupts to avoid any other tasks from interrupting this section of code*/
         interruptStatus = CyEnterCriticalSection();
         
+        /* The SCB needs its clock during a transfer, the next address match wakes it from deep sleep */
+        powerVote(PowerVoteI2C, ((I2C_I2CSlaveStatus() & (I2C_I2C_SSTAT_RD_BUSY | I2C_I2C_SSTAT_WR_BUSY)) != 0u) ? PowerSleep : PowerDeepSleep);
+        allowed = powerAllowed();
+        
         /* Get current state of BLE sub system to check if it has successfully entered deep sleep state */
         blessState = CyBle_GetBleSsState();
 
+        if(eventPending() != 0u)
+        {
+            /* An interrupt posted an event since the main loop looked, handle it first */
+        }
         /* If BLE sub system has entered deep sleep, put chip into deep sleep for reducing power consumption */
-        if(lpMode == CYBLE_BLESS_DEEPSLEEP)
-        {   
-            if(blessState == CYBLE_BLESS_STATE_ECO_ON || blessState == CYBLE_BLESS_STATE_DEEPSLEEP)
-            {
-               /* Put the chip into the deep sleep state as there are no pending tasks and BLE has also 
-               ** successfully entered BLE DEEP SLEEP mode */
-				#ifdef 	LED_INDICATION				
-					ALL_LED_OFF();
-				#endif	/* LED_INDICATION */			
-				I2C_Sleep();
-               	
-				CySysPmDeepSleep();
-				
-				I2C_Wakeup();
-				
+        else if((allowed == PowerDeepSleep) && (lpMode == CYBLE_BLESS_DEEPSLEEP) &&
+                (blessState == CYBLE_BLESS_STATE_ECO_ON || blessState == CYBLE_BLESS_STATE_DEEPSLEEP))
+        {
+            state = PowerDeepSleep;
+            powerAccount(PowerActive);
+            
+           /* Put the chip into the deep sleep state as there are no pending tasks and BLE has also 
+           ** successfully entered BLE DEEP SLEEP mode */
+			#ifdef 	LED_INDICATION				
+				ledSleep();
+			#endif	/* LED_INDICATION */			
+			I2C_Sleep();
+           	
+			CySysPmDeepSleep();
+			
+			I2C_Wakeup();
+			
 #ifdef 	LED_INDICATION	
-				if(CyBle_GetState() == CYBLE_STATE_CONNECTED)
-				{
-					CONNECT_LED_ON();
-				}
-				else
-				{
-					ADV_LED_ON();
-				}
+			ledWakeup();
 #endif	/* LED_INDICATION */
-            }
         }
         /* BLE sub system has not entered deep sleep, wait for completion of radio operations */
         else if(blessState != CYBLE_BLESS_STATE_EVENT_CLOSE)
         {
-            /* change HF clock source from IMO to ECO, as IMO can be stopped to save power */
-            CySysClkWriteHfclkDirect(CY_SYS_CLK_HFCLK_ECO); 
-            
-			/* stop IMO for reducing power consumption */
-            CySysClkImoStop(); 
-            
-			/* put the CPU to sleep */
-            CySysPmSleep();
-            
-			/* starts execution after waking up, start IMO */
-            CySysClkImoStart();
+            state = PowerSleep;
+            powerAccount(PowerActive);
             
-			/* change HF clock source back to IMO */
-            CySysClkWriteHfclkDirect(CY_SYS_CLK_HFCLK_IMO);
+            if((powerVotes[PowerVoteI2C] == PowerDeepSleep) && (lpMode != CYBLE_BLESS_DEEPSLEEP))
+            {
+                /* Radio event in progress and no I2C transfer depending on HFCLK:
+                change HF clock source from IMO to ECO, as IMO can be stopped to save power */
+                CySysClkWriteHfclkDirect(CY_SYS_CLK_HFCLK_ECO); 
+                
+    			/* stop IMO for reducing power consumption */
+                CySysClkImoStop(); 
+                
+    			/* put the CPU to sleep */
+                CySysPmSleep();
+                
+    			/* starts execution after waking up, start IMO */
+                CySysClkImoStart();
+                
+    			/* change HF clock source back to IMO */
+                CySysClkWriteHfclkDirect(CY_SYS_CLK_HFCLK_IMO);
+            }
+            else
+            {
+                /* Wait for the next interrupt, e.g. the end of the I2C transfer */
+                CySysPmSleep();
+            }
         }
+        
+        if(state != PowerActive)
+        {
+            powerStats.entries[state]++;
+            powerAccount(state);
+        }
+        
         /* Enable interrupts back */
         CyExitCriticalSection(interruptStatus);
     }
@@ -16,6 +16,35 @@
 #include "config.h"
 #include "LED.h"	
 	
+/* Power states, from the lightest to the deepest */
+typedef enum
+{
+	PowerActive,		/* keep running the main loop */
+	PowerSleep,			/* CPU sleep, wakes on any interrupt */
+	PowerDeepSleep,		/* CPU deep sleep, wakes on BLESS, WDT or I2C address match */
+	PowerStateCount
+} POWER_STATE_T;
+
+/* Each source votes for the deepest state it can tolerate */
+typedef enum
+{
+	PowerVoteI2C,		/* I2C transfer in progress */
+	PowerVoteNotify,	/* notifications waiting for the stack */
+	PowerVoteLed,		/* LED pattern running */
+	PowerVoteCount
+} POWER_VOTE_T;
+
+typedef struct
+{
+	uint32 entries[PowerStateCount];		/* times the state was entered */
+	uint32 residencyMs[PowerStateCount];	/* time spent in the state */
+} POWER_STATS_T;
+
+extern POWER_STATS_T powerStats;
+
+void powerVote(uint8 source, uint8 deepest);
+uint8 powerAllowed(void);
+
 #ifdef	LOW_POWER_MODE
 	
 void handleLowPowerMode(void); 	
@@ -20,8 +20,7 @@
  */
 #include "main.h"
 
-uint8 wrBuf[I2C_WRITE_BUFFER_SIZE]; /* I2C write buffer */
-uint8 rdBuf[I2C_READ_BUFFER_SIZE];	/* I2C read buffer */
+uint8 *wrBuf;						/* I2C write buffer, a notification slot */
 // uint32 byteCnt;						/* variable to store the number of bytes written by I2C mater */
 
 uint8 sendNotifications;	  /* Flag to check notification enabled/disabled */
@@ -58,15 +57,28 @@ void I2CBrigeInit(void)
 		/* Failed to initialize stack */
 	}
 
+	/* Start time base */
+	appTimerStart();
+
+#ifdef HID_ENABLED
+	/* Consumer control reports for the phone OS */
+	hidInit();
+#endif /* HID_ENABLED */
+
+#ifdef ADV_BROADCAST
+	/* Key for the advertised messages */
+	broadcastInit();
+#endif /* ADV_BROADCAST */
+
 #ifndef ENABLE_I2C_ONLY_WHEN_CONNECTED
 	/* Start I2C Slave operation */
 	I2C_Start();
 
 	/* Initialize I2C write buffer */
-	I2C_I2CSlaveInitWriteBuf((uint8 *)wrBuf, I2C_WRITE_BUFFER_SIZE);
+	initI2CWriteBuffer();
 
 	/* Initialize I2C read buffer */
-	I2C_I2CSlaveInitReadBuf((uint8 *)rdBuf, I2C_READ_BUFFER_SIZE);
+	I2C_I2CSlaveInitReadBuf(rdBuf, I2C_READ_BUFFER_SIZE);
 #endif
 }
 
@@ -113,14 +125,40 @@ int main()
 		/* Process queued BLE events */
 		CyBle_ProcessEvents();
 
-#ifdef ENABLE_I2C_ONLY_WHEN_CONNECTED
-		if (cyBle_state == CYBLE_STATE_CONNECTED)
-		{
-			/* Handle I2C read and write */
-			handleI2CTraffic();
-		}
-#else
-		handleI2CTraffic();
-#endif
+		/* Handle the BLE events queued by AppCallBack and the I2C events
+		posted by the I2C interrupt */
+		handleEvents();
+
+		/* Send queued notifications while the stack has free buffers */
+		handleNotificationQueue();
+
+#ifdef HID_ENABLED
+		/* Send queued consumer control key presses */
+		handleHid();
+#endif /* HID_ENABLED */
+
+		/* Store bonding data once the BLE component asks for it */
+		handleBonding();
+
+		/* Refresh the Telemetry characteristic */
+		handleTelemetry();
+
+		/* Refresh the register file read by the launcher */
+		handleI2CRegisters();
+
+#ifdef LED_INDICATION
+		/* Time the LED patterns */
+		handleLed();
+#endif /* LED_INDICATION */
+
+#ifdef LINK_WARM_UP
+		/* Relax the connection interval once the launcher went quiet */
+		handleLinkPolicy();
+#endif /* LINK_WARM_UP */
+
+#ifdef ADV_BROADCAST
+		/* End advertising bursts and withdraw old messages */
+		handleBroadcast();
+#endif /* ADV_BROADCAST */
 	}
 }
@@ -23,7 +23,17 @@
 #include "project.h"
 #include "config.h"
 #include "app_Ble.h"
+#include "app_Bond.h"
+#include "app_Broadcast.h"
+#include "app_Event.h"
+#include "app_Hid.h"
 #include "app_I2C.h"
+#include "app_Led.h"
+#include "app_Link.h"
+#include "app_Notify.h"
+#include "app_Rx.h"
+#include "app_Telemetry.h"
+#include "app_Timer.h"
 #include "LED.h"
 #include "low_power.h"
 
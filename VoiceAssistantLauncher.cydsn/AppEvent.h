@@ -24,7 +24,11 @@
 enum AppEvent
 {
     EventNull = 0,
-    EventLaunchApp, // iParam = enum AppCode
+    EventLaunchApp,      // iParam = enum AppCode
+    EventTouchIntent,    // iParam = 0, finger landed on the touchpad (BLE link warm-up hint)
+    EventTrackpadStream, // frame = StreamHeader + delta encoded samples
+    EventLedEffect,      // from the phone, iParam = LedChannel << 8 | LedEffect
+    EventStreamEnable,   // from the phone, iParam = 1 to start, 0 to stop the trackpad stream
 };
 
 enum AppCode
@@ -0,0 +1,80 @@
+/*
+ * Copyright (C) 2022 teamprof.net@gmail.com or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include "project.h"
+#include "AppTimer.h"
+
+static volatile uint32 tickMs = 0u;
+
+/********************************************************************************
+ * Function Name: appTimerTick()
+ ******************************************************************************
+ * SysTick callback, called every millisecond
+ *
+ ********************************************************************************/
+static void appTimerTick(void)
+{
+    tickMs++;
+}
+
+/********************************************************************************
+ * Function Name: appTimerStart()
+ ******************************************************************************
+ * hook the millisecond time base on the SysTick timer isr, CySysTickStart() must
+ * be called before
+ *
+ * Parameters:
+ *  None
+ *
+ * Return:
+ *  None
+ *
+ ********************************************************************************/
+void appTimerStart(void)
+{
+    CySysTickSetCallback(APP_TIMER_SYSTICK_SLOT, appTimerTick);
+}
+
+/********************************************************************************
+ * Function Name: appTimerNow()
+ ******************************************************************************
+ * Return:
+ *  milliseconds since appTimerStart(), wraps around
+ *
+ ********************************************************************************/
+uint32 appTimerNow(void)
+{
+    return tickMs;
+}
+
+/********************************************************************************
+ * Function Name: appTimerElapsed()
+ ******************************************************************************
+ * Parameters:
+ *  since: time stamp returned by appTimerNow()
+ *
+ * Return:
+ *  milliseconds passed since the time stamp
+ *
+ ********************************************************************************/
+uint32 appTimerElapsed(uint32 since)
+{
+    return tickMs - since;
+}
@@ -0,0 +1,299 @@
+/*
+ * Copyright (C) 2022 teamprof.net@gmail.com or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include "project.h"
+#include "AppLog.h"
+#include "AppTimer.h"
+#include "ClockGovernor.h"
+
+/* Divider register values of the design (active frequency) */
+typedef struct _ClockDivider
+{
+    uint16 div;
+    uint8 frac;
+} ClockDivider;
+
+static ClockDivider uartClk;
+static ClockDivider i2cClk;
+static ClockDivider pwmClk;
+static uint8 modCsdClk;
+static uint16 snsClk;
+static uint16 rowSnsClk;
+
+static uint8 clockEnabled = 0u;
+static uint8 clockIdle = 0u;
+static uint32 lastActiveTime = 0u;
+
+/* Scaling the sense clock dividers changes the modulator frequency and with
+ * it the raw counts, each HFCLK then needs baselines of its own. The ones of
+ * the other frequency are parked here. */
+static CapSense_RAM_SNS_STRUCT otherSensors[CapSense_TOUCHPAD0_NUM_SENSORS];
+static uint8 otherValid = 0u;
+static uint8 rebaseline = 0u; /* take the baselines from the next scan */
+
+/********************************************************************************
+ * Function Name: halfDivider()
+ ******************************************************************************
+ * divide a clock divider by two, the divider is in 1/32 steps
+ * (register value + 1) * 32 + fractional value
+ *
+ ********************************************************************************/
+static ClockDivider halfDivider(const ClockDivider *clk)
+{
+    ClockDivider half;
+    uint32 total = ((((uint32)clk->div + 1u) << 5u) + clk->frac) >> 1u;
+
+    half.div = (uint16)((total >> 5u) - 1u);
+    half.frac = (uint8)(total & 0x1Fu);
+    return half;
+}
+
+/********************************************************************************
+ * Function Name: swapBaselines()
+ ******************************************************************************
+ * park the sensors of the old HFCLK and bring back the ones of the new HFCLK.
+ * Without baselines of the new HFCLK yet they are taken from the next scan,
+ * the first switch goes to idle, so no finger is on the touchpad.
+ *
+ ********************************************************************************/
+static void swapBaselines(void)
+{
+    CapSense_RAM_SNS_STRUCT sensor;
+    uint8 i;
+
+    for (i = 0u; i < CapSense_TOUCHPAD0_NUM_SENSORS; i++)
+    {
+        sensor = CapSense_dsRam.snsList.touchpad0[i];
+        if (0u != otherValid)
+        {
+            CapSense_dsRam.snsList.touchpad0[i] = otherSensors[i];
+        }
+        otherSensors[i] = sensor;
+    }
+
+    rebaseline = (0u == otherValid);
+    otherValid = 1u;
+}
+
+/********************************************************************************
+ * Function Name: writeDividers()
+ ******************************************************************************
+ * update SCB, TCPWM and CapSense dividers for the given HFCLK
+ *
+ ********************************************************************************/
+static void writeDividers(uint8 idle)
+{
+    ClockDivider uart = uartClk;
+    ClockDivider i2c = i2cClk;
+    ClockDivider pwm = pwmClk;
+
+    if (0u != idle)
+    {
+        uart = halfDivider(&uartClk);
+        i2c = halfDivider(&i2cClk);
+        pwm = halfDivider(&pwmClk);
+    }
+    UART_SCBCLK_SetFractionalDividerRegister(uart.div, uart.frac);
+    I2C_SCBCLK_SetFractionalDividerRegister(i2c.div, i2c.frac);
+    Clock_1_SetFractionalDividerRegister(pwm.div, pwm.frac);
+
+    /* Keep the sense clock, prefer the modulator clock divider as it keeps the scan resolution */
+    if (0u == (modCsdClk & 1u))
+    {
+        CapSense_dsRam.modCsdClk = (0u != idle) ? (modCsdClk >> 1u) : modCsdClk;
+        CapSense_SsSetModClkClockDivider((uint32)CapSense_dsRam.modCsdClk);
+    }
+    else
+    {
+        CapSense_dsRam.wdgtList.touchpad0.snsClk = (0u != idle) ? (snsClk >> 1u) : snsClk;
+        CapSense_dsRam.wdgtList.touchpad0.rowSnsClk = (0u != idle) ? (rowSnsClk >> 1u) : rowSnsClk;
+        swapBaselines();
+    }
+}
+
+/********************************************************************************
+ * Function Name: sysTickCount()
+ ******************************************************************************
+ * SysTick counts from one value to a later one, the counter counts down
+ *
+ ********************************************************************************/
+static uint32 sysTickCount(uint32 from, uint32 to, uint32 reload)
+{
+    return (from >= to) ? (from - to) : (from + reload - to);
+}
+
+/********************************************************************************
+ * Function Name: switchClock()
+ ******************************************************************************
+ * switch HFCLK between active and idle frequency, must be called between two
+ * CapSense scans
+ *
+ ********************************************************************************/
+static void switchClock(uint8 idle)
+{
+    uint32 mhz = (0u != idle) ? CLOCK_IDLE_MHZ : CLOCK_ACTIVE_MHZ;
+    uint32 oldMhz = (0u != idle) ? CLOCK_ACTIVE_MHZ : CLOCK_IDLE_MHZ;
+    uint32 reload = CySysTickGetReload();
+    uint32 start;
+    uint32 change;
+    uint32 stop;
+    uint8 interruptState;
+
+    interruptState = CyEnterCriticalSection();
+    start = CySysTickGetValue();
+
+    if (0u != idle)
+    {
+        /* Slow down the peripherals first, then the source */
+        writeDividers(idle);
+        CySysClkWriteImoFreq(mhz);
+        change = CySysTickGetValue();
+    }
+    else
+    {
+        CySysClkWriteImoFreq(mhz);
+        change = CySysTickGetValue();
+        writeDividers(idle);
+    }
+
+    /* Keep CyDelay() and the 1 ms SysTick (gesture time stamp) accurate */
+    CyDelayFreq(mhz * 1000000u);
+    CySysTickSetReload(mhz * 1000u);
+
+    stop = CySysTickGetValue();
+    CyExitCriticalSection(interruptState);
+
+    clockIdle = idle;
+
+    /* SysTick counts down at HFCLK, up to the IMO change at the old frequency */
+    DBGLOG(Debug, "HFCLK %lu MHz, switch took %lu us", mhz,
+           (sysTickCount(start, change, reload) / oldMhz) + (sysTickCount(change, stop, reload) / mhz));
+}
+
+/********************************************************************************
+ * Function Name: clockGovernorStart()
+ ******************************************************************************
+ * save the dividers of the design, call after all components are started
+ *
+ * Parameters:
+ *  None
+ *
+ * Return:
+ *  None
+ *
+ ********************************************************************************/
+void clockGovernorStart(void)
+{
+    uartClk.div = UART_SCBCLK_GetDividerRegister();
+    uartClk.frac = UART_SCBCLK_GetFractionalDividerRegister();
+    i2cClk.div = I2C_SCBCLK_GetDividerRegister();
+    i2cClk.frac = I2C_SCBCLK_GetFractionalDividerRegister();
+    pwmClk.div = Clock_1_GetDividerRegister();
+    pwmClk.frac = Clock_1_GetFractionalDividerRegister();
+    modCsdClk = CapSense_dsRam.modCsdClk;
+    snsClk = CapSense_dsRam.wdgtList.touchpad0.snsClk;
+    rowSnsClk = CapSense_dsRam.wdgtList.touchpad0.rowSnsClk;
+
+    /* CapSense clocks can only be halved when one of the dividers is even */
+    clockEnabled = (0u == (modCsdClk & 1u)) || ((0u == (snsClk & 1u)) && (0u == (rowSnsClk & 1u)));
+    if (0u == clockEnabled)
+    {
+        DBGLOG(Info, "CapSense dividers are odd, clock governor disabled");
+    }
+
+    lastActiveTime = appTimerNow();
+}
+
+/********************************************************************************
+ * Function Name: clockGovernorUpdate()
+ ******************************************************************************
+ * raise HFCLK as soon as the touchpad is active, drop it after
+ * CLOCK_IDLE_TIMEOUT_MS. Call after a CapSense scan was processed and before
+ * the next scan starts.
+ *
+ * Parameters:
+ *  active: none zero if a finger is on the touchpad
+ *
+ * Return:
+ *  None
+ *
+ ********************************************************************************/
+void clockGovernorUpdate(uint8 active)
+{
+    if (0u == clockEnabled)
+    {
+        return;
+    }
+
+    if (0u != active)
+    {
+        lastActiveTime = appTimerNow();
+    }
+
+    /* Bytes on the wire would be corrupted by a switch, try again after the next scan */
+    if ((0u != UART_SpiUartGetTxBufferSize()) || (0u != (I2C_I2CMasterStatus() & I2C_I2C_MSTAT_XFER_INP)))
+    {
+        return;
+    }
+
+    if ((0u != clockIdle) && (0u != active))
+    {
+        switchClock(0u);
+    }
+    else if ((0u == clockIdle) && (appTimerElapsed(lastActiveTime) >= CLOCK_IDLE_TIMEOUT_MS))
+    {
+        switchClock(1u);
+    }
+}
+
+/********************************************************************************
+ * Function Name: clockGovernorScanDone()
+ ******************************************************************************
+ * take the baselines from the scan after the first switch that changed the
+ * modulator frequency. Call when a CapSense scan is complete, before it is
+ * processed.
+ *
+ * Parameters:
+ *  None
+ *
+ * Return:
+ *  None
+ *
+ ********************************************************************************/
+void clockGovernorScanDone(void)
+{
+    if (0u != rebaseline)
+    {
+        rebaseline = 0u;
+        CapSense_InitializeAllBaselines();
+    }
+}
+
+/********************************************************************************
+ * Function Name: clockGovernorIsIdle()
+ ******************************************************************************
+ * Return:
+ *  1 while HFCLK runs at CLOCK_IDLE_MHZ
+ *
+ ********************************************************************************/
+uint8 clockGovernorIsIdle(void)
+{
+    return clockIdle;
+}
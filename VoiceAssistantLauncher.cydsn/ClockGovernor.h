@@ -0,0 +1,36 @@
+/*
+ * Copyright (C) 2022 teamprof.net@gmail.com or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#pragma once
+#include "project.h"
+
+/* HFCLK is taken directly from the IMO, both frequencies in MHz. ACTIVE must be
+ * the frequency of the design (.cydwr) and IDLE exactly half of it, so that
+ * every peripheral divider can be scaled without changing its output clock. */
+#define CLOCK_ACTIVE_MHZ 48u
+#define CLOCK_IDLE_MHZ 24u
+
+/* Drop to idle frequency when no finger was detected for this time */
+#define CLOCK_IDLE_TIMEOUT_MS 2000u
+
+extern void clockGovernorStart(void);
+extern void clockGovernorUpdate(uint8 active);
+extern void clockGovernorScanDone(void);
+extern uint8 clockGovernorIsIdle(void);
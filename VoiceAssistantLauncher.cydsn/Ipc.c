@@ -0,0 +1,548 @@
+/*
+ * Copyright (C) 2022 teamprof.net@gmail.com or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include <string.h>
+#include "project.h"
+#include "./AppLog.h"
+#include "./AppTimer.h"
+#include "./Ipc.h"
+
+IpcQueue ipcQueue;
+IpcRxStats ipcRxStats;
+BridgeRegisters ipcBridge;
+
+/* Bulk frame, sent only while no message is queued */
+static uint8 ipcFrame[IPC_FRAME_SIZE_MAX];
+static uint8 ipcFrameSize = 0u;
+static uint8 ipcFrameRetry = 0u;
+static uint32 ipcFrameTime = 0u;
+static uint8 ipcStarve = 0u; /* messages written in a row while a frame waited */
+
+/* Receive path */
+static uint8 ipcRxBuf[IPC_RX_SIZE];
+static uint8 ipcRxRetry = 0u;
+static volatile uint8 ipcRxEdge = 0u; /* DATA_READY went high, set by the isr */
+static uint8 ipcBlob[IPC_BLOB_SIZE_MAX];
+static uint16 ipcBlobSize = 0u;
+static uint8 ipcBlobValid = 0u; /* chunks received in order since the first one */
+static IpcMessageHandler ipcOnMessage = NULL;
+static IpcBlobHandler ipcOnBlob = NULL;
+
+/* Register file */
+static uint8 ipcRegAddress = 0u; /* offset written before the read */
+static BridgeRegisters ipcRegBuf;
+static uint32 ipcRegTime = 0u;
+static uint8 ipcRegDue = 1u;
+static uint8 ipcCredits = 0u; /* frames the bridge takes until the next register read */
+static uint8 ipcHeld = 0u;    /* pending frame is waiting for credit */
+
+enum IpcTransfer
+{
+    IpcIdle = 0,
+    IpcMessage,
+    IpcFrame,
+    IpcRead,
+    IpcRegSelect,
+    IpcRegRead
+};
+
+static uint8 ipcBusy = IpcIdle;
+
+/********************************************************************************
+ * Function Name: ipcDataReadyIsr()
+ ******************************************************************************
+ * the bridge has data for us, it is read by ipcProcess()
+ *
+ ********************************************************************************/
+static CY_ISR(ipcDataReadyIsr)
+{
+    DATA_READY_ClearInterrupt();
+    ipcRxEdge = 1u;
+}
+
+/********************************************************************************
+ * Function Name: ipcChunk()
+ ******************************************************************************
+ * add a blob chunk in ipcRxBuf to ipcBlob, the last chunk hands the blob to
+ * the blob handler. A chunk out of order drops the blob.
+ *
+ ********************************************************************************/
+static void ipcChunk(void)
+{
+    uint8 flags = ipcRxBuf[0];
+    uint16 offset = (uint16)(ipcRxBuf[1] | ((uint16)ipcRxBuf[2] << 8));
+    uint8 size = ipcRxBuf[3];
+
+    if (0u != (flags & IPC_CHUNK_FIRST))
+    {
+        ipcBlobSize = 0u;
+        ipcBlobValid = 1u;
+    }
+
+    if ((0u == ipcBlobValid) || (offset != ipcBlobSize) ||
+        (size > (IPC_RX_SIZE - IPC_CHUNK_HEADER)) || ((offset + size) > IPC_BLOB_SIZE_MAX))
+    {
+        if (0u != ipcBlobValid)
+        {
+            DBGLOG(Debug, "drop blob, chunk at %hu of %hu bytes", offset, (uint16)size);
+            ipcRxStats.dropped++;
+        }
+        ipcBlobValid = 0u;
+        return;
+    }
+
+    (void)memcpy(&ipcBlob[offset], &ipcRxBuf[IPC_CHUNK_HEADER], size);
+    ipcBlobSize += size;
+
+    if (0u != (flags & IPC_CHUNK_LAST))
+    {
+        ipcBlobValid = 0u;
+        ipcRxStats.blobs++;
+        if (NULL != ipcOnBlob)
+        {
+            ipcOnBlob(ipcBlob, ipcBlobSize);
+        }
+    }
+}
+
+/********************************************************************************
+ * Function Name: ipcReadComplete()
+ ******************************************************************************
+ * decode the data read from the bridge, a failed read is repeated up to
+ * IPC_RETRY_MAX times
+ *
+ * Parameters:
+ *  status: I2C master status of the read
+ *
+ ********************************************************************************/
+static void ipcReadComplete(uint32 status)
+{
+    Message msg;
+
+    if ((0u != (status & I2C_I2C_MSTAT_ERR_XFER)) || (I2C_I2CMasterGetReadBufSize() != IPC_RX_SIZE))
+    {
+        if (++ipcRxRetry < IPC_RETRY_MAX)
+        {
+            ipcRxEdge = 1u;
+        }
+        else
+        {
+            DBGLOG(Debug, "drop read, I2C status 0x%lx", status);
+            ipcRxRetry = 0u;
+            ipcRxStats.dropped++;
+        }
+        return;
+    }
+    ipcRxRetry = 0u;
+
+    if (IPC_CHUNK_TAG == (ipcRxBuf[0] & IPC_CHUNK_TAG_MASK))
+    {
+        ipcChunk();
+        return;
+    }
+
+    (void)memcpy(&msg, ipcRxBuf, sizeof(msg));
+    ipcRxStats.messages++;
+    if (NULL != ipcOnMessage)
+    {
+        ipcOnMessage(&msg);
+    }
+}
+
+/********************************************************************************
+ * Function Name: ipcRegComplete()
+ ******************************************************************************
+ * take the register file read from the bridge and renew the credits, a failed
+ * read or a bridge without the register file leaves ipcBridge unknown
+ * (version 0)
+ *
+ * Parameters:
+ *  status: I2C master status of the read
+ *
+ ********************************************************************************/
+static void ipcRegComplete(uint32 status)
+{
+    if ((0u != (status & I2C_I2C_MSTAT_ERR_XFER)) ||
+        (I2C_I2CMasterGetReadBufSize() != sizeof(ipcRegBuf)) ||
+        (ipcRegBuf.version < IPC_REG_VERSION) || (ipcRegBuf.size < sizeof(ipcRegBuf)))
+    {
+        if (0u != ipcBridge.version)
+        {
+            DBGLOG(Debug, "register read failed, I2C status 0x%lx", status);
+        }
+        ipcBridge.version = 0u;
+        return;
+    }
+
+    ipcBridge = ipcRegBuf;
+    ipcCredits = (ipcBridge.ntfFree > IPC_CREDIT_RESERVE) ? (uint8)(ipcBridge.ntfFree - IPC_CREDIT_RESERVE) : 0u;
+}
+
+/********************************************************************************
+ * Function Name: ipcFrameAllowed()
+ ******************************************************************************
+ * decide on the pending bulk frame with the last register file: it is dropped
+ * while no phone is connected (stale once the phone is back) and held while
+ * there is no credit. Without a register file the frame is always written.
+ *
+ * Return:
+ *  1 if the frame can be written now, 0 otherwise
+ *
+ ********************************************************************************/
+static uint8 ipcFrameAllowed(void)
+{
+    if (0u == ipcBridge.version)
+    {
+        return 1u;
+    }
+
+    if (0u == (ipcBridge.state & IPC_REG_STATE_CONNECTED))
+    {
+        ipcQueue.dropped++;
+        ipcFrameSize = 0u;
+        ipcFrameRetry = 0u;
+        ipcHeld = 0u;
+        return 0u;
+    }
+
+    if (0u == ipcCredits)
+    {
+        if (0u == ipcHeld)
+        {
+            ipcHeld = 1u;
+            ipcQueue.framesHeld++;
+        }
+        return 0u;
+    }
+
+    ipcHeld = 0u;
+    ipcCredits--;
+    return 1u;
+}
+
+/********************************************************************************
+ * Function Name: ipcLaneSent()
+ ******************************************************************************
+ * add a completed write to the statistics of its lane
+ *
+ * Parameters:
+ *  lane: enum IpcLane
+ *  posted: appTimerNow() when the message or frame was posted
+ *
+ ********************************************************************************/
+static void ipcLaneSent(uint8 lane, uint32 posted)
+{
+    IpcLaneStats *stats = &ipcQueue.lane[lane];
+    uint32 latency = appTimerElapsed(posted);
+
+    stats->sent++;
+    stats->latencySum += latency;
+    if (latency > stats->latencyMax)
+    {
+        stats->latencyMax = latency;
+    }
+}
+
+/********************************************************************************
+ * Function Name: ipcPop()
+ ******************************************************************************
+ * remove the head message from the queue
+ *
+ ********************************************************************************/
+static void ipcPop(void)
+{
+    ipcQueue.head = (uint8)((ipcQueue.head + 1u) % IPC_QUEUE_SIZE);
+    ipcQueue.count--;
+    ipcQueue.retry = 0u;
+}
+
+/********************************************************************************
+ * Function Name: ipcPostMessage()
+ ******************************************************************************
+ * queue a message for EZ-BLE™ PRoC™ Module (CYBLE-022001-00), it is sent by
+ * ipcProcess()
+ *
+ * Parameters: msg
+ * The message to be written to the slave device (EZ-BLE™ PRoC™ Module)
+ *
+ * Return:
+ *  1 if the message was queued, 0 if the queue is full
+ *
+ ********************************************************************************/
+uint8 ipcPostMessage(const Message *msg)
+{
+    if (ipcQueue.count >= IPC_QUEUE_SIZE)
+    {
+        return 0u;
+    }
+
+    ipcQueue.msg[(ipcQueue.head + ipcQueue.count) % IPC_QUEUE_SIZE] = *msg;
+    ipcQueue.time[(ipcQueue.head + ipcQueue.count) % IPC_QUEUE_SIZE] = appTimerNow();
+    ipcQueue.count++;
+    return 1u;
+}
+
+/********************************************************************************
+ * Function Name: ipcPostFrame()
+ ******************************************************************************
+ * hand a bulk frame (e.g. trackpad stream) to the IPC. There is a single frame
+ * slot and queued messages go first, up to IPC_STARVE_MAX in a row.
+ *
+ * Parameters:
+ *  frame: frame to be written to the slave device, it is copied
+ *  size: number of bytes, up to IPC_FRAME_SIZE_MAX
+ *
+ * Return:
+ *  1 if the frame was taken, 0 if the previous frame is still pending
+ *
+ ********************************************************************************/
+uint8 ipcPostFrame(const uint8 *frame, uint8 size)
+{
+    if ((0u != ipcFrameSize) || (size > IPC_FRAME_SIZE_MAX))
+    {
+        return 0u;
+    }
+
+    (void)memcpy(ipcFrame, frame, size);
+    ipcFrameSize = size;
+    ipcFrameTime = appTimerNow();
+    return 1u;
+}
+
+/********************************************************************************
+ * Function Name: ipcSetReceiver()
+ ******************************************************************************
+ * set the handlers of data written by the phone and start listening to the
+ * DATA_READY line of EZ-BLE™ PRoC™ Module. The handlers are called from
+ * ipcProcess().
+ *
+ * Parameters:
+ *  onMessage: called for every Message
+ *  onBlob: called for every complete blob, the blob is only valid during the call
+ *
+ * Return:
+ *  None
+ *
+ ********************************************************************************/
+void ipcSetReceiver(IpcMessageHandler onMessage, IpcBlobHandler onBlob)
+{
+    ipcOnMessage = onMessage;
+    ipcOnBlob = onBlob;
+
+    DATA_READY_SetInterruptMode(DATA_READY_INTR_ALL, DATA_READY_INTR_RISING);
+    DATA_READY_ClearInterrupt();
+    CyIntSetVector(IPC_DATA_READY_IRQ, &ipcDataReadyIsr);
+    CyIntEnable(IPC_DATA_READY_IRQ);
+
+    /* Data published before we listened */
+    if (0u != DATA_READY_Read())
+    {
+        ipcRxEdge = 1u;
+    }
+}
+
+/********************************************************************************
+ * Function Name: ipcProcess()
+ ******************************************************************************
+ * send queued messages via high level I2C api without blocking, call from the
+ * main loop. The head message stays in the queue until the bridge acknowledged
+ * all of its bytes. A frame waiting behind IPC_STARVE_MAX messages goes next.
+ * Data the bridge signalled with DATA_READY is read right after the queued
+ * messages, then the register file every IPC_STATUS_MS (IPC_CREDIT_POLL_MS
+ * while a frame waits for credit) and last bulk
+ * frames, which the register file may hold back or drop.
+ *
+ * Parameters:
+ *  None
+ *
+ * Return:
+ *  None
+ *
+ ********************************************************************************/
+void ipcProcess(void)
+{
+    if (IpcRead == ipcBusy)
+    {
+        uint32 status = I2C_I2CMasterStatus();
+
+        /* Wait until I2C Master completes read transfer */
+        if (0u == (status & I2C_I2C_MSTAT_RD_CMPLT))
+        {
+            return;
+        }
+
+        ipcBusy = IpcIdle;
+        ipcReadComplete(status);
+    }
+    else if (IpcRegSelect == ipcBusy)
+    {
+        uint32 status = I2C_I2CMasterStatus();
+
+        if (0u == (status & I2C_I2C_MSTAT_WR_CMPLT))
+        {
+            return;
+        }
+
+        ipcBusy = IpcIdle;
+        if (0u != (status & I2C_I2C_MSTAT_ERR_XFER))
+        {
+            ipcRegComplete(status);
+        }
+        else
+        {
+            /* The bus is still ours, read the registers with a repeated start */
+            (void)I2C_I2CMasterClearStatus();
+            if (I2C_I2C_MSTR_NO_ERROR == I2C_I2CMasterReadBuf(I2C_SLAVE_ADDR, (uint8 *)&ipcRegBuf,
+                                                              sizeof(ipcRegBuf), I2C_I2C_MODE_REPEAT_START))
+            {
+                ipcBusy = IpcRegRead;
+                return;
+            }
+            ipcBridge.version = 0u;
+        }
+    }
+    else if (IpcRegRead == ipcBusy)
+    {
+        uint32 status = I2C_I2CMasterStatus();
+
+        if (0u == (status & I2C_I2C_MSTAT_RD_CMPLT))
+        {
+            return;
+        }
+
+        ipcBusy = IpcIdle;
+        ipcRegComplete(status);
+    }
+    else if (IpcIdle != ipcBusy)
+    {
+        uint32 status = I2C_I2CMasterStatus();
+        uint32 size = (IpcMessage == ipcBusy) ? sizeof(Message) : ipcFrameSize;
+        uint8 done;
+
+        /* Wait until I2C Master completes write transfer */
+        if (0u == (status & I2C_I2C_MSTAT_WR_CMPLT))
+        {
+            return;
+        }
+
+        /* Check transfer status and if all bytes were written */
+        done = (0u == (status & I2C_I2C_MSTAT_ERR_XFER)) && (I2C_I2CMasterGetWriteBufSize() == size);
+
+        if (IpcMessage == ipcBusy)
+        {
+            if (0u != done)
+            {
+                /* The message took one of the slots the credits left */
+                if (0u != ipcCredits)
+                {
+                    ipcCredits--;
+                }
+                if (0u != ipcFrameSize)
+                {
+                    ipcStarve++;
+                }
+                ipcLaneSent(IpcLaneControl, ipcQueue.time[ipcQueue.head]);
+                ipcQueue.sent++;
+                ipcPop();
+            }
+            else if (++ipcQueue.retry >= IPC_RETRY_MAX)
+            {
+                DBGLOG(Debug, "drop message %hd, I2C status 0x%lx", ipcQueue.msg[ipcQueue.head].event, status);
+                ipcQueue.dropped++;
+                ipcPop();
+            }
+        }
+        else if ((0u != done) || (++ipcFrameRetry >= IPC_RETRY_MAX))
+        {
+            if (0u != done)
+            {
+                ipcLaneSent(IpcLaneBulk, ipcFrameTime);
+                ipcQueue.framesSent++;
+            }
+            else
+            {
+                ipcQueue.dropped++;
+            }
+            ipcFrameSize = 0u;
+            ipcFrameRetry = 0u;
+            ipcStarve = 0u;
+        }
+        ipcBusy = IpcIdle;
+    }
+
+    /* Messages (e.g. launch events) preempt bulk frames until the frame starved */
+    if ((0u != ipcQueue.count) && ((0u == ipcFrameSize) || (ipcStarve < IPC_STARVE_MAX)))
+    {
+        (void)I2C_I2CMasterClearStatus();
+
+        /* Start I2C write, the buffer must stay untouched until the transfer completes */
+        if (I2C_I2C_MSTR_NO_ERROR == I2C_I2CMasterWriteBuf(I2C_SLAVE_ADDR,
+                                                           (uint8 *)&ipcQueue.msg[ipcQueue.head], sizeof(Message),
+                                                           I2C_I2C_MODE_COMPLETE_XFER))
+        {
+            ipcBusy = IpcMessage;
+        }
+    }
+    else if (0u != ipcRxEdge)
+    {
+        /* A new edge during the read asks for another read */
+        ipcRxEdge = 0u;
+        (void)I2C_I2CMasterClearStatus();
+
+        if (I2C_I2C_MSTR_NO_ERROR == I2C_I2CMasterReadBuf(I2C_SLAVE_ADDR, ipcRxBuf, IPC_RX_SIZE,
+                                                          I2C_I2C_MODE_COMPLETE_XFER))
+        {
+            ipcBusy = IpcRead;
+        }
+        else
+        {
+            ipcRxEdge = 1u;
+        }
+    }
+    else if ((0u != ipcRegDue) ||
+             (appTimerElapsed(ipcRegTime) >= ((0u != ipcHeld) ? IPC_CREDIT_POLL_MS : IPC_STATUS_MS)))
+    {
+        /* Select the register file and read it in the same transaction */
+        ipcRegDue = 0u;
+        ipcRegTime = appTimerNow();
+        (void)I2C_I2CMasterClearStatus();
+
+        if (I2C_I2C_MSTR_NO_ERROR == I2C_I2CMasterWriteBuf(I2C_SLAVE_ADDR, &ipcRegAddress, sizeof(ipcRegAddress),
+                                                           I2C_I2C_MODE_NO_STOP))
+        {
+            ipcBusy = IpcRegSelect;
+        }
+    }
+    else if ((0u != ipcFrameSize) && (0u == ipcFrameAllowed()))
+    {
+        /* A held or dropped frame does not block the messages */
+        ipcStarve = 0u;
+    }
+    else if (0u != ipcFrameSize)
+    {
+        (void)I2C_I2CMasterClearStatus();
+
+        if (I2C_I2C_MSTR_NO_ERROR == I2C_I2CMasterWriteBuf(I2C_SLAVE_ADDR, ipcFrame, ipcFrameSize,
+                                                           I2C_I2C_MODE_COMPLETE_XFER))
+        {
+            ipcBusy = IpcFrame;
+        }
+    }
+}
@@ -0,0 +1,98 @@
+/*
+ * Copyright (C) 2022 teamprof.net@gmail.com or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#pragma once
+#include "project.h"
+#include "./Message.h"
+
+/* I2C address of EZ-BLE™ PRoC™ Module (CYBLE-022001-00) */
+#define I2C_SLAVE_ADDR (0x08u)
+
+/* Number of messages waiting for the I2C bus */
+#define IPC_QUEUE_SIZE 8u
+
+/* Number of attempts before a message is dropped */
+#define IPC_RETRY_MAX 3u
+
+/* Messages (launch and control events) are written ahead of bulk frames,
+ * but after IPC_STARVE_MAX messages in a row one waiting frame goes */
+#define IPC_STARVE_MAX 4u
+
+enum IpcLane
+{
+    IpcLaneControl = 0, /* messages */
+    IpcLaneBulk,        /* frames */
+    IpcLaneCount
+};
+
+/* Interval of reading the register file of the bridge (ms) */
+#define IPC_STATUS_MS 500u
+
+/* Bulk frames are written against credits, the free slots of the bridge
+ * notification queue less IPC_CREDIT_RESERVE kept for messages. Without
+ * credit the frame is held (the trackpad stream coalesces samples) and the
+ * register file is read every IPC_CREDIT_POLL_MS. */
+#define IPC_CREDIT_RESERVE 2u
+#define IPC_CREDIT_POLL_MS 20u
+
+/* Data from the phone is read once the bridge raises its DATA_READY line. The
+ * DATA_READY input pin (P2[5]) interrupts on the rising edge through the
+ * vector of its port, GPIO port n is IRQ n on the PSoC 4100S. */
+#define IPC_DATA_READY_IRQ ((uint8)DATA_READY__PORT)
+
+typedef void (*IpcMessageHandler)(const Message *msg);
+typedef void (*IpcBlobHandler)(const uint8 *blob, uint16 size);
+
+typedef struct _IpcRxStats
+{
+    uint32 messages; /* messages received */
+    uint32 blobs;    /* blobs received */
+    uint32 dropped;  /* failed reads and incomplete blobs */
+} IpcRxStats;
+
+typedef struct _IpcLaneStats
+{
+    uint32 sent;       /* written to the bridge */
+    uint32 latencySum; /* post to the end of the write (ms) */
+    uint32 latencyMax;
+} IpcLaneStats;
+
+typedef struct _IpcQueue
+{
+    Message msg[IPC_QUEUE_SIZE];
+    uint32 time[IPC_QUEUE_SIZE]; /* time the message was posted */
+    uint8 head;  /* index of the oldest message, in transfer when ipc is busy */
+    uint8 count; /* number of messages in the queue */
+    uint8 retry; /* failed attempts of the head message */
+    uint32 sent;       /* messages */
+    uint32 framesSent; /* bulk frames */
+    uint32 dropped;    /* messages and frames */
+    uint32 framesHeld; /* frames held back for lack of credit */
+    IpcLaneStats lane[IpcLaneCount];
+} IpcQueue;
+
+extern IpcQueue ipcQueue;
+extern IpcRxStats ipcRxStats;
+extern BridgeRegisters ipcBridge;
+
+extern uint8 ipcPostMessage(const Message *msg);
+extern uint8 ipcPostFrame(const uint8 *frame, uint8 size);
+extern void ipcSetReceiver(IpcMessageHandler onMessage, IpcBlobHandler onBlob);
+extern void ipcProcess(void);
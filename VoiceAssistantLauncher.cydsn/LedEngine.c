@@ -0,0 +1,278 @@
+/*
+ * Copyright (C) 2022 teamprof.net@gmail.com or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include "project.h"
+#include "./LedEngine.h"
+
+#define LED_STEPS(ms) (((ms) + LED_ENGINE_PERIOD_MS - 1u) / LED_ENGINE_PERIOD_MS)
+
+/* PWM duty (counts) for every brightness level, gamma 2.2:
+ * round(PWM_LED_OFF * (level / 255) ^ 2.2) */
+static const uint16 ledGamma[LED_LEVEL_MAX + 1u] = {
+        0,     0,     0,     1,     1,     2,     3,     4,     5,     6,     8,    10,
+       12,    14,    17,    20,    23,    26,    29,    33,    37,    41,    46,    50,
+       55,    60,    66,    72,    78,    84,    90,    97,   104,   111,   119,   127,
+      135,   143,   152,   161,   170,   179,   189,   199,   210,   220,   231,   242,
+      254,   266,   278,   290,   303,   316,   329,   342,   356,   370,   385,   400,
+      415,   430,   446,   462,   478,   494,   511,   528,   546,   564,   582,   600,
+      619,   638,   658,   677,   697,   718,   738,   759,   781,   802,   824,   846,
+      869,   892,   915,   939,   963,   987,  1012,  1036,  1062,  1087,  1113,  1139,
+     1166,  1193,  1220,  1248,  1275,  1304,  1332,  1361,  1390,  1420,  1450,  1480,
+     1511,  1542,  1573,  1605,  1637,  1669,  1702,  1735,  1768,  1802,  1836,  1870,
+     1905,  1940,  1975,  2011,  2047,  2084,  2121,  2158,  2195,  2233,  2272,  2310,
+     2349,  2389,  2428,  2468,  2509,  2549,  2591,  2632,  2674,  2716,  2759,  2802,
+     2845,  2888,  2932,  2977,  3022,  3067,  3112,  3158,  3204,  3251,  3298,  3345,
+     3393,  3441,  3489,  3538,  3587,  3636,  3686,  3737,  3787,  3838,  3889,  3941,
+     3993,  4046,  4099,  4152,  4205,  4259,  4314,  4369,  4424,  4479,  4535,  4591,
+     4648,  4705,  4762,  4820,  4878,  4937,  4996,  5055,  5114,  5175,  5235,  5296,
+     5357,  5419,  5480,  5543,  5606,  5669,  5732,  5796,  5860,  5925,  5990,  6055,
+     6121,  6187,  6254,  6321,  6388,  6456,  6524,  6593,  6662,  6731,  6801,  6871,
+     6941,  7012,  7084,  7155,  7227,  7300,  7373,  7446,  7520,  7594,  7668,  7743,
+     7818,  7894,  7970,  8046,  8123,  8200,  8278,  8356,  8435,  8513,  8593,  8672,
+     8752,  8833,  8914,  8995,  9076,  9158,  9241,  9324,  9407,  9491,  9575,  9659,
+     9744,  9829,  9915, 10001
+};
+
+typedef struct _LedState
+{
+    volatile uint8 posted;  /* effect posted by the application, LedEffectNone once taken */
+    volatile uint8 track;   /* level posted by ledEngineTrack() */
+    volatile uint8 tracked; /* a new track level was posted */
+    uint8 effect;           /* running effect */
+    uint8 level;            /* current level */
+    uint8 base;             /* level to return to after a flash */
+    uint16 step;            /* step of the running effect */
+    uint16 compare;         /* last value written to the PWM */
+} LedState;
+
+static LedState ledState[LedChannels];
+static uint8 ledTick = 0u;
+
+/********************************************************************************
+ * Function Name: ledWrite()
+ ******************************************************************************
+ * write the PWM compare value of a channel if it changed
+ *
+ ********************************************************************************/
+static void ledWrite(uint8 channel, LedState *led)
+{
+    uint16 compare = (uint16)(PWM_LED_OFF - ledGamma[led->level]);
+
+    if (compare != led->compare)
+    {
+        led->compare = compare;
+        if (LedBlue == channel)
+        {
+            PWM_Blue_WriteCompare(compare);
+        }
+        else
+        {
+            PWM_Green_WriteCompare(compare);
+        }
+    }
+}
+
+/********************************************************************************
+ * Function Name: ledRamp()
+ ******************************************************************************
+ * level of a linear ramp in perceived brightness
+ *
+ ********************************************************************************/
+static uint8 ledRamp(uint8 from, uint8 to, uint16 step, uint16 steps)
+{
+    if (step >= steps)
+    {
+        return to;
+    }
+    return (uint8)((int16)from + (((int16)to - (int16)from) * (int16)step) / (int16)steps);
+}
+
+/********************************************************************************
+ * Function Name: ledRun()
+ ******************************************************************************
+ * advance the effect of a channel by one engine period
+ *
+ ********************************************************************************/
+static void ledRun(LedState *led)
+{
+    uint8 posted = led->posted;
+    uint16 half = LED_STEPS(LED_BREATHE_MS) / 2u;
+
+    if (LedEffectNone != posted)
+    {
+        led->posted = LedEffectNone;
+        led->effect = posted;
+        led->base = led->level;
+        led->step = 0u;
+    }
+
+    switch (led->effect)
+    {
+    case LedEffectOff:
+        led->level = LED_LEVEL_OFF;
+        led->effect = LedEffectNone;
+        break;
+
+    case LedEffectOn:
+        led->level = LED_LEVEL_ON;
+        led->effect = LedEffectNone;
+        break;
+
+    case LedEffectFadeIn:
+    case LedEffectFadeOut:
+        led->level = ledRamp(led->base, (LedEffectFadeIn == led->effect) ? LED_LEVEL_ON : LED_LEVEL_OFF,
+                             ++led->step, LED_STEPS(LED_FADE_MS));
+        if (led->step >= LED_STEPS(LED_FADE_MS))
+        {
+            led->effect = LedEffectNone;
+        }
+        break;
+
+    case LedEffectBreathe:
+        led->step = (uint16)((led->step + 1u) % (2u * half));
+        led->level = (led->step < half) ? ledRamp(LED_LEVEL_OFF, LED_LEVEL_ON, led->step, half)
+                                        : ledRamp(LED_LEVEL_ON, LED_LEVEL_OFF, led->step - half, half);
+        break;
+
+    case LedEffectFlash:
+        led->level = LED_LEVEL_MAX;
+        if (++led->step >= LED_STEPS(LED_FLASH_MS))
+        {
+            led->level = led->base;
+            led->effect = LedEffectNone;
+        }
+        break;
+
+    default:
+        /* Follow the finger position as long as the light is not off */
+        if ((0u != led->tracked) && (LED_LEVEL_OFF != led->level))
+        {
+            led->level = (LED_LEVEL_OFF != led->track) ? led->track : 1u;
+        }
+        led->tracked = 0u;
+        break;
+    }
+}
+
+/********************************************************************************
+ * Function Name: ledEngineIsr()
+ ******************************************************************************
+ * SysTick callback, called every millisecond
+ *
+ ********************************************************************************/
+static void ledEngineIsr(void)
+{
+    uint8 channel;
+
+    if (++ledTick < LED_ENGINE_PERIOD_MS)
+    {
+        return;
+    }
+    ledTick = 0u;
+
+    for (channel = 0u; channel < LedChannels; channel++)
+    {
+        ledRun(&ledState[channel]);
+        ledWrite(channel, &ledState[channel]);
+    }
+}
+
+/********************************************************************************
+ * Function Name: ledLevelOf()
+ ******************************************************************************
+ * level of a PWM compare value, inverse of the gamma table
+ *
+ ********************************************************************************/
+static uint8 ledLevelOf(uint32 compare)
+{
+    uint32 duty = (compare < PWM_LED_OFF) ? (PWM_LED_OFF - compare) : 0u;
+    uint8 level = 0u;
+
+    while ((level < LED_LEVEL_MAX) && (ledGamma[level] < duty))
+    {
+        level++;
+    }
+    return level;
+}
+
+/********************************************************************************
+ * Function Name: ledEngineStart()
+ ******************************************************************************
+ * take over the LEDs at the compare values of the design and hook the engine on
+ * the SysTick timer isr, the PWMs and CySysTickStart() must be started before
+ *
+ * Parameters:
+ *  None
+ *
+ * Return:
+ *  None
+ *
+ ********************************************************************************/
+void ledEngineStart(void)
+{
+    uint8 channel;
+
+    ledState[LedBlue].level = ledLevelOf(PWM_Blue_ReadCompare());
+    ledState[LedGreen].level = ledLevelOf(PWM_Green_ReadCompare());
+
+    for (channel = 0u; channel < LedChannels; channel++)
+    {
+        ledWrite(channel, &ledState[channel]);
+    }
+    CySysTickSetCallback(LED_ENGINE_SYSTICK_SLOT, ledEngineIsr);
+}
+
+/********************************************************************************
+ * Function Name: ledEnginePost()
+ ******************************************************************************
+ * start a preset effect, returns immediately. The effect is taken by the next
+ * engine period.
+ *
+ * Parameters:
+ *  channel: enum LedChannel
+ *  effect: enum LedEffect
+ *
+ * Return:
+ *  None
+ *
+ ********************************************************************************/
+void ledEnginePost(uint8 channel, uint8 effect)
+{
+    ledState[channel].posted = effect;
+}
+
+/********************************************************************************
+ * Function Name: ledEngineTrack()
+ ******************************************************************************
+ * set the brightness of a channel which is on and runs no effect
+ *
+ * Parameters:
+ *  channel: enum LedChannel
+ *  level: LED_LEVEL_OFF .. LED_LEVEL_MAX
+ *
+ * Return:
+ *  None
+ *
+ ********************************************************************************/
+void ledEngineTrack(uint8 channel, uint8 level)
+{
+    ledState[channel].track = level;
+    ledState[channel].tracked = 1u;
+}
@@ -0,0 +1,65 @@
+/*
+ * Copyright (C) 2022 teamprof.net@gmail.com or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#pragma once
+#include "project.h"
+
+/* PWM duty cycles for zero and fifty percent */
+#define PWM_LED_OFF 10001
+#define PWM_LED_HALF_POWER 5000
+
+/* Scales x and y value of the touchpad to PWM compare value */
+#define PWM_SCALAR 100
+
+/* SysTick callback slot of the LED engine, the engine runs every LED_ENGINE_PERIOD_MS */
+#define LED_ENGINE_SYSTICK_SLOT 2u
+#define LED_ENGINE_PERIOD_MS 10u
+
+/* Perceived brightness, mapped to PWM compare values by the gamma table */
+#define LED_LEVEL_OFF 0u
+#define LED_LEVEL_ON 128u
+#define LED_LEVEL_MAX 255u
+
+/* Duration of the preset effects */
+#define LED_FADE_MS 300u
+#define LED_BREATHE_MS 2000u /* one period */
+#define LED_FLASH_MS 80u
+
+enum LedChannel
+{
+    LedBlue = 0,
+    LedGreen,
+    LedChannels
+};
+
+enum LedEffect
+{
+    LedEffectNone = 0, // keep the current effect
+    LedEffectOff,      // off immediately
+    LedEffectOn,       // LED_LEVEL_ON immediately
+    LedEffectFadeIn,   // fade to LED_LEVEL_ON
+    LedEffectFadeOut,  // fade to off
+    LedEffectBreathe,  // fade in and out until another effect is posted
+    LedEffectFlash     // short flash at LED_LEVEL_MAX, then back to the previous level
+};
+
+extern void ledEngineStart(void);
+extern void ledEnginePost(uint8 channel, uint8 effect);
+extern void ledEngineTrack(uint8 channel, uint8 level);
@@ -29,4 +29,56 @@ typedef struct _Message
     // uint16 uParam;
     // uint32 lParam;
 } Message;
-#pragma pack(pop)
\ No newline at end of file
+
+/* Largest frame accepted by EZ-BLE™ PRoC™ Module (I2C_WRITE_BUFFER_SIZE) */
+#define IPC_FRAME_SIZE_MAX 61
+
+/* Read from the bridge once it raised DATA_READY: a Message written by the
+ * phone, or a chunk of a larger blob [flags][offset:2][length][data] */
+#define IPC_RX_SIZE 61
+#define IPC_CHUNK_TAG_MASK 0xFCu
+#define IPC_CHUNK_TAG 0xC0u /* no event starts with it */
+#define IPC_CHUNK_FIRST 0x01u
+#define IPC_CHUNK_LAST 0x02u
+#define IPC_CHUNK_HEADER 4u
+#define IPC_BLOB_SIZE_MAX 512u
+
+/* EventTrackpadStream frame: header followed by (count - 1) int8 dx, dy pairs */
+typedef struct _StreamHeader
+{
+    int16 event;
+    uint8 seq;   /* frame sequence number */
+    uint8 count; /* number of samples in the frame */
+    uint16 x;    /* first sample, absolute */
+    uint16 y;
+} StreamHeader;
+#pragma pack(pop)
+
+/* Register file of the bridge, selected by writing its offset (one byte) and
+ * read back in the same transaction. Fields are only appended, a newer bridge
+ * reports a larger size. */
+#define IPC_REG_VERSION 2u
+#define IPC_REG_STATE_CONNECTED 0x01u
+#define IPC_REG_STATE_ADVERTISING 0x02u
+#define IPC_REG_STATE_NOTIFY 0x04u
+#define IPC_REG_STATE_DATA_READY 0x08u
+#define IPC_REG_STATE_PACED 0x10u
+
+#pragma pack(push, 1)
+typedef struct _BridgeRegisters
+{
+    uint8 version;     /* IPC_REG_VERSION, 0 until the first read */
+    uint8 size;        /* size of the register file */
+    uint8 state;       /* IPC_REG_STATE_xxx */
+    uint8 lastError;   /* last BLE API error */
+    uint8 ntfQueued;   /* frames waiting for the phone */
+    uint8 ntfFree;     /* frames the bridge takes before it drops */
+    uint16 mtu;        /* ATT MTU */
+    uint16 interval;   /* connection interval (1.25 ms units), 0 if unknown */
+    uint16 rxLeft;     /* blob bytes not read yet */
+    uint32 i2cFrames;  /* frames written by us */
+    uint32 ntfSent;    /* frames notified */
+    uint32 ntfDropped; /* frames dropped */
+    uint8 credits;     /* frames the phone takes, 0xFF for 255 and more */
+} BridgeRegisters;
+#pragma pack(pop)
@@ -0,0 +1,263 @@
+/*
+ * Copyright (C) 2022 teamprof.net@gmail.com or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include "project.h"
+#include "./AppEvent.h"
+#include "./AppLog.h"
+#include "./AppTimer.h"
+#include "./Ipc.h"
+#include "./Message.h"
+#include "./TrackpadStream.h"
+
+#define STREAM_TOKEN 1000u /* one frame, the bucket is refilled STREAM_FRAME_RATE_MAX tokens per second */
+
+static uint8 streamEnabled = 0u;
+
+/* Frame under construction, the union keeps the header aligned */
+static union
+{
+    StreamHeader header;
+    uint8 bytes[IPC_FRAME_SIZE_MAX];
+} frame;
+static uint8 frameSize = 0u;
+static uint8 frameSeq = 0u;
+static uint8 frameFlush = 0u;
+static uint32 frameTime = 0u;
+static uint16 lastX = 0u;
+static uint16 lastY = 0u;
+
+/* Rate control */
+static uint32 tokens = 0u;
+static uint32 tokenTime = 0u;
+
+/* Throughput */
+static uint32 samplesSent = 0u;
+static uint32 samplesDropped = 0u;
+static uint32 reportTime = 0u;
+static uint32 reportSamples = 0u;
+static uint32 reportFrames = 0u;
+
+/********************************************************************************
+ * Function Name: laneAverage()
+ ******************************************************************************
+ * average latency of an IPC lane in ms, 0 before its first write
+ *
+ ********************************************************************************/
+static uint32 laneAverage(uint8 lane)
+{
+    const IpcLaneStats *stats = &ipcQueue.lane[lane];
+
+    return (0u != stats->sent) ? (stats->latencySum / stats->sent) : 0u;
+}
+
+/********************************************************************************
+ * Function Name: streamStart()
+ ******************************************************************************
+ * start a new frame with an absolute sample
+ *
+ ********************************************************************************/
+static void streamStart(uint16 x, uint16 y)
+{
+    frame.header.event = EventTrackpadStream;
+    frame.header.seq = frameSeq;
+    frame.header.count = 1u;
+    frame.header.x = x;
+    frame.header.y = y;
+    frameSize = sizeof(StreamHeader);
+    frameTime = appTimerNow();
+}
+
+/********************************************************************************
+ * Function Name: streamFlush()
+ ******************************************************************************
+ * hand the frame under construction to the IPC if the rate allows
+ *
+ * Return:
+ *  1 if the frame was sent (or empty), 0 if it is still pending
+ *
+ ********************************************************************************/
+static uint8 streamFlush(void)
+{
+    uint32 elapsed = appTimerElapsed(tokenTime);
+
+    if (0u == frameSize)
+    {
+        return 1u;
+    }
+
+    /* Refill the token bucket */
+    tokenTime += elapsed;
+    tokens += elapsed * STREAM_FRAME_RATE_MAX;
+    if (tokens > (STREAM_FRAME_BURST * STREAM_TOKEN))
+    {
+        tokens = STREAM_FRAME_BURST * STREAM_TOKEN;
+    }
+
+    if ((tokens < STREAM_TOKEN) || (0u == ipcPostFrame(frame.bytes, frameSize)))
+    {
+        return 0u;
+    }
+
+    tokens -= STREAM_TOKEN;
+    samplesSent += frame.header.count;
+    frameSeq++;
+    frameSize = 0u;
+    frameFlush = 0u;
+    return 1u;
+}
+
+/********************************************************************************
+ * Function Name: streamEnable()
+ ******************************************************************************
+ * start or stop streaming the finger position
+ *
+ * Parameters:
+ *  enable: 0 to stop
+ *
+ * Return:
+ *  None
+ *
+ ********************************************************************************/
+void streamEnable(uint8 enable)
+{
+    streamEnabled = (0u != enable);
+    frameSize = 0u;
+    frameFlush = 0u;
+    tokens = STREAM_FRAME_BURST * STREAM_TOKEN;
+    tokenTime = appTimerNow();
+    reportTime = appTimerNow();
+    reportSamples = samplesSent;
+    reportFrames = ipcQueue.framesSent;
+
+    DBGLOG(Info, "trackpad stream %s", (0u != streamEnabled) ? "on" : "off");
+}
+
+/********************************************************************************
+ * Function Name: streamIsEnabled()
+ ******************************************************************************
+ * Return:
+ *  1 while streaming
+ *
+ ********************************************************************************/
+uint8 streamIsEnabled(void)
+{
+    return streamEnabled;
+}
+
+/********************************************************************************
+ * Function Name: streamSample()
+ ******************************************************************************
+ * add the finger position of a scan to the stream, samples are delta encoded
+ * against the previous sample of the frame
+ *
+ * Parameters:
+ *  xy: value returned from CapSense_GetXYCoordinates()
+ *
+ * Return:
+ *  None
+ *
+ ********************************************************************************/
+void streamSample(uint32 xy)
+{
+    uint16 x = (uint16)xy;
+    uint16 y = (uint16)(xy >> 16);
+    int32 dx = (int32)x - (int32)lastX;
+    int32 dy = (int32)y - (int32)lastY;
+
+    if (0u == streamEnabled)
+    {
+        return;
+    }
+
+    if (xy == CapSense_TOUCHPAD_NO_TOUCH)
+    {
+        /* Finger lifted, send what we have */
+        frameFlush = (0u != frameSize);
+        return;
+    }
+
+    lastX = x;
+    lastY = y;
+
+    if (0u == frameSize)
+    {
+        streamStart(x, y);
+        return;
+    }
+
+    /* A frame ends when it is full or a delta does not fit into int8 */
+    if (((frameSize + 2u) > IPC_FRAME_SIZE_MAX) || (dx < -128) || (dx > 127) || (dy < -128) || (dy > 127))
+    {
+        if (0u == streamFlush())
+        {
+            /* Link is behind, drop the old samples rather than adding latency */
+            samplesDropped += frame.header.count;
+        }
+        streamStart(x, y);
+        return;
+    }
+
+    frame.bytes[frameSize++] = (uint8)(int8)dx;
+    frame.bytes[frameSize++] = (uint8)(int8)dy;
+    frame.header.count++;
+}
+
+/********************************************************************************
+ * Function Name: streamProcess()
+ ******************************************************************************
+ * send the frame once STREAM_FLUSH_MS passed or the finger was lifted, and
+ * report the throughput. Call from the main loop.
+ *
+ * Parameters:
+ *  None
+ *
+ * Return:
+ *  None
+ *
+ ********************************************************************************/
+void streamProcess(void)
+{
+    uint32 elapsed;
+
+    if (0u == streamEnabled)
+    {
+        return;
+    }
+
+    if ((0u != frameSize) && ((0u != frameFlush) || (appTimerElapsed(frameTime) >= STREAM_FLUSH_MS)))
+    {
+        (void)streamFlush();
+    }
+
+    elapsed = appTimerElapsed(reportTime);
+    if (elapsed >= STREAM_REPORT_MS)
+    {
+        DBGLOG(Info, "stream %lu samples/s, %lu frames/s, %lu samples dropped",
+               ((samplesSent - reportSamples) * 1000u) / elapsed,
+               ((ipcQueue.framesSent - reportFrames) * 1000u) / elapsed,
+               samplesDropped);
+        DBGLOG(Info, "ipc latency control %lu/%lu ms, bulk %lu/%lu ms (avg/max)",
+               laneAverage(IpcLaneControl), ipcQueue.lane[IpcLaneControl].latencyMax,
+               laneAverage(IpcLaneBulk), ipcQueue.lane[IpcLaneBulk].latencyMax);
+        reportTime += elapsed;
+        reportSamples = samplesSent;
+        reportFrames = ipcQueue.framesSent;
+    }
+}
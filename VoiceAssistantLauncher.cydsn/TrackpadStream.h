@@ -0,0 +1,38 @@
+/*
+ * Copyright (C) 2022 teamprof.net@gmail.com or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#pragma once
+#include "project.h"
+
+/* Longest time a sample waits in a frame before the frame is sent */
+#define STREAM_FLUSH_MS 30u
+
+/* Frame rate limit, keeps the BLE link below saturation. Up to
+ * STREAM_FRAME_BURST frames may be sent back to back after a pause. */
+#define STREAM_FRAME_RATE_MAX 40u
+#define STREAM_FRAME_BURST 2u
+
+/* Interval of the throughput report on the debug log */
+#define STREAM_REPORT_MS 1000u
+
+extern void streamEnable(uint8 enable);
+extern uint8 streamIsEnabled(void);
+extern void streamSample(uint32 xy);
+extern void streamProcess(void);
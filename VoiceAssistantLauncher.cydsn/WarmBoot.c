@@ -0,0 +1,202 @@
+/*
+ * Copyright (C) 2022 teamprof.net@gmail.com or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include <stddef.h>
+#include <string.h>
+#include "project.h"
+#include "./AppTimer.h"
+#include "./ClockGovernor.h"
+#include "./Ipc.h"
+#include "./WarmBoot.h"
+
+/* State kept in RAM which is not initialized by the startup code */
+typedef struct _WarmBootRam
+{
+    uint32 magic;
+    IpcQueue ipc;
+    uint32 clock; /* appTimerNow() when ipc was saved, kept current while messages are queued */
+    AppCounters counters;
+    uint8 capSenseValid;
+    CapSense_RAM_WD_CSD_TOUCHPAD_STRUCT widget; /* calibrated IDACs */
+    CapSense_RAM_SNS_STRUCT sensors[CapSense_TOUCHPAD0_NUM_SENSORS]; /* baselines */
+    uint16 crc;
+} WarmBootRam;
+
+CY_NOINIT static WarmBootRam warmRam;
+
+AppCounters appCounters;
+
+static uint32 lastSaveTime = 0u;
+
+/********************************************************************************
+ * Function Name: crc16()
+ ******************************************************************************
+ * CRC-16/CCITT-FALSE
+ *
+ ********************************************************************************/
+static uint16 crc16(const uint8 *data, uint32 size)
+{
+    uint16 crc = 0xFFFFu;
+    uint32 i;
+
+    while (0u != size--)
+    {
+        crc ^= (uint16)((uint16)*data++ << 8u);
+        for (i = 0u; i < 8u; i++)
+        {
+            crc = (0u != (crc & 0x8000u)) ? (uint16)((crc << 1u) ^ 0x1021u) : (uint16)(crc << 1u);
+        }
+    }
+    return crc;
+}
+
+/********************************************************************************
+ * Function Name: warmRamCrc()
+ ******************************************************************************
+ * CRC over everything but the crc field
+ *
+ ********************************************************************************/
+static uint16 warmRamCrc(void)
+{
+    return crc16((const uint8 *)&warmRam, (uint32)offsetof(WarmBootRam, crc));
+}
+
+/********************************************************************************
+ * Function Name: warmBootRestore()
+ ******************************************************************************
+ * check the no-init RAM and restore IPC queue and counters from it. Call before
+ * any component is started, but after appTimerStart().
+ *
+ * Parameters:
+ *  None
+ *
+ * Return:
+ *  1 on a warm boot (e.g. after watchdog or software reset), 0 on a cold boot
+ *
+ ********************************************************************************/
+uint8 warmBootRestore(void)
+{
+    uint8 warm = (WARM_BOOT_MAGIC == warmRam.magic) && (warmRam.crc == warmRamCrc());
+    uint32 now = appTimerNow();
+    uint8 index;
+    uint8 i;
+
+    if (0u != warm)
+    {
+        ipcQueue = warmRam.ipc;
+
+        /* Post times are from the time base of the previous boot, their age
+        is taken against the clock saved with them. The queue is in post
+        order, stale messages are dropped from the head, the others keep
+        their age in the new time base. */
+        while ((0u != ipcQueue.count) &&
+               ((warmRam.clock - ipcQueue.time[ipcQueue.head]) >= WARM_BOOT_IPC_AGE_MS))
+        {
+            ipcQueue.head = (uint8)((ipcQueue.head + 1u) % IPC_QUEUE_SIZE);
+            ipcQueue.count--;
+            ipcQueue.retry = 0u;
+            ipcQueue.dropped++;
+        }
+        for (i = 0u; i < ipcQueue.count; i++)
+        {
+            index = (uint8)((ipcQueue.head + i) % IPC_QUEUE_SIZE);
+            ipcQueue.time[index] = now - (warmRam.clock - ipcQueue.time[index]);
+        }
+        appCounters = warmRam.counters;
+        appCounters.warmBoots++;
+    }
+    else
+    {
+        /* Power on or brown-out, RAM content is undefined */
+        (void)memset(&warmRam, 0, sizeof(warmRam));
+        warmRam.magic = WARM_BOOT_MAGIC;
+        appCounters.coldBoots++;
+    }
+    return warm;
+}
+
+/********************************************************************************
+ * Function Name: warmBootRestoreCapSense()
+ ******************************************************************************
+ * restore calibrated IDACs and baselines, call after CapSense_Initialize()
+ * instead of running the calibration and baseline initialization of
+ * CapSense_Start()
+ *
+ * Parameters:
+ *  None
+ *
+ * Return:
+ *  1 if CapSense was restored, 0 if CapSense_Start() is still required
+ *
+ ********************************************************************************/
+uint8 warmBootRestoreCapSense(void)
+{
+    if (0u == warmRam.capSenseValid)
+    {
+        return 0u;
+    }
+
+    CapSense_dsRam.wdgtList.touchpad0 = warmRam.widget;
+    (void)memcpy(CapSense_dsRam.snsList.touchpad0, warmRam.sensors, sizeof(warmRam.sensors));
+    return 1u;
+}
+
+/********************************************************************************
+ * Function Name: warmBootUpdate()
+ ******************************************************************************
+ * refresh the no-init RAM, call from the main loop after a scan was processed
+ *
+ * Parameters:
+ *  None
+ *
+ * Return:
+ *  None
+ *
+ ********************************************************************************/
+void warmBootUpdate(void)
+{
+    uint8 ipcChanged = (warmRam.ipc.head != ipcQueue.head) || (warmRam.ipc.count != ipcQueue.count);
+    uint8 timeout = (appTimerElapsed(lastSaveTime) >= WARM_BOOT_SAVE_INTERVAL_MS);
+
+    /* While messages are queued the clock is saved every scan, their age
+    after a restart is off by the restart only */
+    if ((0u == ipcChanged) && (0u == timeout) && (0u == ipcQueue.count))
+    {
+        return;
+    }
+
+    warmRam.ipc = ipcQueue;
+    warmRam.clock = appTimerNow();
+    warmRam.counters = appCounters;
+
+    if (0u != timeout)
+    {
+        /* Sense clock dividers are halved while HFCLK is idle, keep the active ones */
+        if (0u == clockGovernorIsIdle())
+        {
+            warmRam.widget = CapSense_dsRam.wdgtList.touchpad0;
+            (void)memcpy(warmRam.sensors, CapSense_dsRam.snsList.touchpad0, sizeof(warmRam.sensors));
+            warmRam.capSenseValid = 1u;
+        }
+        lastSaveTime = appTimerNow();
+    }
+
+    warmRam.crc = warmRamCrc();
+}
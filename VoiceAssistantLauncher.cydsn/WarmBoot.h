@@ -0,0 +1,47 @@
+/*
+ * Copyright (C) 2022 teamprof.net@gmail.com or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#pragma once
+#include "project.h"
+
+#define WARM_BOOT_MAGIC 0x5741524Du /* "WARM" */
+
+/* CapSense baselines are saved at this interval, the IPC queue whenever it changes */
+#define WARM_BOOT_SAVE_INTERVAL_MS 1000u
+
+/* Queued messages older than this at the restart are dropped, a launch
+ * request replayed later than that would surprise the user */
+#define WARM_BOOT_IPC_AGE_MS 2000u
+
+/* Counters which survive a warm restart */
+typedef struct _AppCounters
+{
+    uint32 coldBoots;
+    uint32 warmBoots;
+    uint32 launches;
+    uint32 coldFirstScanMs; /* time from the start of the time base to the first processed scan */
+    uint32 warmFirstScanMs;
+} AppCounters;
+
+extern AppCounters appCounters;
+
+extern uint8 warmBootRestore(void);
+extern uint8 warmBootRestoreCapSense(void);
+extern void warmBootUpdate(void);
@@ -21,71 +21,72 @@
 #include "project.h"
 #include "./AppEvent.h"
 #include "./AppLog.h"
+#include "./AppTimer.h"
+#include "./ClockGovernor.h"
+#include "./Ipc.h"
+#include "./LedEngine.h"
 #include "./Message.h"
+#include "./TrackpadStream.h"
+#include "./WarmBoot.h"
 
 /***************************************
  *              Constants
  ****************************************/
-#define I2C_SLAVE_ADDR (0x08u)
-
-/* Transfer statuses */
-#define TRANSFER_CMPLT (0x00u)
-#define TRANSFER_ERROR (0xFFu)
-
-/* PWM duty cycles for zero and fifty percent */
-#define PWM_LED_OFF 10001
-#define PWM_LED_HALF_POWER 5000
-
-/* Scales x and y value of the touchpad to PWM compare value */
-#define PWM_SCALAR 100
-
 /*  */
 #define LED_OFF 1
 #define LED_ON 0
 
 /********************************************************************************
- * Function Name: ipcSendMessage()
+ * Function Name: ledTrackLevel()
  ******************************************************************************
- * send message to EZ-BLE™ PRoC™ Module (CYBLE-022001-00) via high level I2C api
+ * map a touchpad coordinate to a LED level, a larger coordinate is darker
+ *
+ ********************************************************************************/
+static uint8 ledTrackLevel(uint16 cord)
+{
+    uint32 range = PWM_LED_OFF / PWM_SCALAR;
+
+    if (cord >= range)
+    {
+        return LED_LEVEL_OFF;
+    }
+    return (uint8)(LED_LEVEL_MAX - ((uint32)cord * LED_LEVEL_MAX) / range);
+}
+
+/********************************************************************************
+ * Function Name: handlerTouch()
+ ******************************************************************************
+ * send a touch intent hint to EZ-BLE™ PRoC™ Module as soon as a finger lands on
+ * the touchpad, so that the BLE link is fast by the time a gesture completes
  *
- * Parameters: msg
- * The message to be written to the slave device (EZ-BLE™ PRoC™ Module)
+ * Parameters:
+ *  xy: value returned from CapSense_GetXYCoordinates()
  *
  * Return:
- * Status of the transfer. There are two statuses
- *  - TRANSFER_CMPLT: transfer completed successfully.
- *  - TRANSFER_ERROR: an error occurred durring transfer.
+ *  None
  *
  ********************************************************************************/
-static uint32 ipcSendMessage(const Message *msg)
+static void handlerTouch(uint32 xy)
 {
-    uint32 status = TRANSFER_ERROR;
-
-    (void)I2C_I2CMasterClearStatus();
+    static uint8 touched = 0u;
+    Message msg;
 
-    /* Start I2C write and check status */
-    if (I2C_I2C_MSTR_NO_ERROR == I2C_I2CMasterWriteBuf(I2C_SLAVE_ADDR,
-                                                       (void *)msg, sizeof(*msg),
-                                                       I2C_I2C_MODE_COMPLETE_XFER))
+    if (xy == CapSense_TOUCHPAD_NO_TOUCH)
     {
-        /* If I2C write started without errors,
-         * wait until I2C Master completes write transfer */
-        while (0u == (I2C_I2CMasterStatus() & I2C_I2C_MSTAT_WR_CMPLT))
-        {
-        }
+        touched = 0u;
+    }
+    else if (0u == touched)
+    {
+        touched = 1u;
+
+        msg.event = EventTouchIntent;
+        msg.iParam = 0;
 
-        /* Report transfer status */
-        if (0u == (I2C_I2CMasterStatus() & I2C_I2C_MSTAT_ERR_XFER))
+        if (0u == ipcPostMessage(&msg))
         {
-            /* Check if all bytes were written */
-            if (I2C_I2CMasterGetWriteBufSize() == sizeof(*msg))
-            {
-                status = TRANSFER_CMPLT;
-            }
+            DBGLOG(Debug, "ipcPostMessage() queue full");
         }
     }
-
-    return (status);
 }
 
 /********************************************************************************
@@ -103,13 +104,13 @@ static uint32 ipcSendMessage(const Message *msg)
  ********************************************************************************/
 static void handlerGesture(uint32 gesture, uint32 xy)
 {
-    uint32 ipcRst;
     Message msg;
 
     switch (gesture)
     {
     case CapSense_ONE_FINGER_SINGLE_CLICK:
         DBGLOG(Debug, "CapSense_ONE_FINGER_SINGLE_CLICK");
+        ledEnginePost(LedBlue, LedEffectFlash);
         break;
 
     case CapSense_ONE_FINGER_EDGE_SWIPE_LEFT:
@@ -122,23 +123,23 @@ static void handlerGesture(uint32 gesture, uint32 xy)
 
     case CapSense_ONE_FINGER_ROTATE_CW:
         DBGLOG(Debug, "CapSense_ONE_FINGER_ROTATE_CW");
-        PWM_Green_WriteCompare(PWM_LED_HALF_POWER);
+        ledEnginePost(LedGreen, LedEffectFadeIn);
 
         msg.event = EventLaunchApp;
         msg.iParam = AppVoiceAssistant;
         // msg.uParam = 0;
         // msg.lParam = 0L;
 
-        ipcRst = ipcSendMessage(&msg);
-        if (TRANSFER_CMPLT != ipcRst)
+        appCounters.launches++;
+        if (0u == ipcPostMessage(&msg))
         {
-            DBGLOG(Debug, "ipcSendMessage() returns %lu", ipcRst);
+            DBGLOG(Debug, "ipcPostMessage() queue full");
         }
         break;
 
     case CapSense_ONE_FINGER_ROTATE_CCW:
         DBGLOG(Debug, "CapSense_ONE_FINGER_ROTATE_CCW");
-        PWM_Green_WriteCompare(PWM_LED_OFF);
+        ledEnginePost(LedGreen, LedEffectFadeOut);
         break;
 
     default:
@@ -148,21 +149,77 @@ static void handlerGesture(uint32 gesture, uint32 xy)
             uint16 Ycord = (uint16)(xy >> 16);
             uint16 Xcord = (uint16)xy;
 
-            /* Change the PWM compare value based on finger position as long as the light was not off */
-            PWM_Blue_WriteCompare(PWM_Blue_ReadCompare() == PWM_LED_OFF ? PWM_LED_OFF : (Xcord * PWM_SCALAR));
-            PWM_Green_WriteCompare(PWM_Green_ReadCompare() == PWM_LED_OFF ? PWM_LED_OFF : (Ycord * PWM_SCALAR));
+            /* Change the brightness based on finger position as long as the light was not off */
+            ledEngineTrack(LedBlue, ledTrackLevel(Xcord));
+            ledEngineTrack(LedGreen, ledTrackLevel(Ycord));
+        }
+        break;
+    }
+}
+
+/********************************************************************************
+ * Function Name: handlerMessage()
+ ******************************************************************************
+ * handle a message written by the phone, read from EZ-BLE™ PRoC™ Module
+ *
+ * Parameters:
+ *  msg: message
+ *
+ * Return:
+ *  None
+ *
+ ********************************************************************************/
+static void handlerMessage(const Message *msg)
+{
+    uint8 channel = (uint8)((uint16)msg->iParam >> 8);
+    uint8 effect = (uint8)msg->iParam;
+
+    switch (msg->event)
+    {
+    case EventLedEffect:
+        DBGLOG(Debug, "EventLedEffect %hu %hu", (uint16)channel, (uint16)effect);
+        if ((channel < LedChannels) && (effect <= LedEffectFlash))
+        {
+            ledEnginePost(channel, effect);
         }
         break;
+
+    case EventStreamEnable:
+        DBGLOG(Debug, "EventStreamEnable %hd", msg->iParam);
+        streamEnable(0 != msg->iParam);
+        break;
+
+    default:
+        DBGLOG(Debug, "unknown message %hd", msg->event);
+        break;
     }
 }
 
+/********************************************************************************
+ * Function Name: handlerBlob()
+ ******************************************************************************
+ * handle a blob written by the phone, e.g. a gesture map
+ *
+ * Parameters:
+ *  blob: data, only valid during the call
+ *  size: number of bytes
+ *
+ * Return:
+ *  None
+ *
+ ********************************************************************************/
+static void handlerBlob(const uint8 *blob, uint16 size)
+{
+    DBGLOG(Info, "blob of %hu bytes, first byte 0x%02hx", size, (uint16)blob[0]);
+}
+
 /*******************************************************************************
  * Function Name: main
  ********************************************************************************
  * Summary:
  *  The main function performs the following actions:
- *   1. Starts all hardware Components
- *   2. Starts the timestamp
+ *   1. Restores state kept in no-init RAM on a warm boot
+ *   2. Starts all hardware Components and the timestamp
  *   3. Initial scan of all CapSense widgets
  *   4. Checks if scan is complete
  *   4. Process all data and update time stamp
@@ -179,28 +236,57 @@ static void handlerGesture(uint32 gesture, uint32 xy)
  *******************************************************************************/
 int main(void)
 {
+    uint8 warmBoot;
+    uint8 firstScan = 1u;
+
     CyGlobalIntEnable; /* Enable global interrupts. */
 
+    /* Start the time base first, it measures the time to the first scan */
+    CySysTickStart();
+    appTimerStart();
+
+    /* Restores IPC queue and counters after a watchdog or software reset */
+    warmBoot = warmBootRestore();
+
     /* Starts all Componenets */
     PWM_Blue_Start();
     PWM_Green_Start();
     I2C_Start();
     // EZI2C_Start();
+
+    /* Messages from the phone, read when the bridge raises DATA_READY */
+    ipcSetReceiver(handlerMessage, handlerBlob);
     UART_Start();
 
-    CapSense_Start();
+    /* Calibration and baseline initialization are skipped on a warm boot */
+    if (0u != warmBoot)
+    {
+        CapSense_Initialize();
+    }
+    if ((0u == warmBoot) || (0u == warmBootRestoreCapSense()))
+    {
+        CapSense_Start();
+    }
 
     // /* Set up communication data buffer to CapSense data structure to be exposed to I2C master */
     // EZI2C_EzI2CSetBuffer1(sizeof(CapSense_dsRam), sizeof(CapSense_dsRam), (uint8 *)&CapSense_dsRam);
 
     /* Sets up a callback function using sysTick timer isr, the callback function is part of the CySysTickSetCallback API */
     CapSense_dsRam.timestampInterval = 2u;
-    CySysTickStart();
     CySysTickSetCallback(0u, CapSense_IncrementGestureTimestamp);
 
-    PRINTLN("\r\n***********************************************************************************");
-    PRINTLN("Voice Assistant Launcher firmware v1.0");
-    PRINTLN("***********************************************************************************");
+    /* LED effects run from the SysTick timer isr */
+    ledEngineStart();
+
+    /* Scale HFCLK down while the touchpad is idle */
+    clockGovernorStart();
+
+    if (0u == warmBoot)
+    {
+        PRINTLN("\r\n***********************************************************************************");
+        PRINTLN("Voice Assistant Launcher firmware v1.0");
+        PRINTLN("***********************************************************************************");
+    }
 
     CapSense_ScanAllWidgets();
 
@@ -209,6 +295,9 @@ int main(void)
         /* Checks if the scan was completed before trying to process data */
         if (CapSense_NOT_BUSY == CapSense_IsBusy())
         {
+            /* Baselines follow a change of the modulator frequency */
+            clockGovernorScanDone();
+
             CapSense_ProcessAllWidgets();
 
             /* Stores the current detected gesture */
@@ -217,19 +306,55 @@ int main(void)
             /* Stores current finger position on the touchpad */
             uint32 XYcordinates = CapSense_GetXYCoordinates(CapSense_TOUCHPAD0_WDGT_ID);
 
+            handlerTouch(XYcordinates);
             handlerGesture(gesture, XYcordinates);
 
+            /* Remote pointer samples, one per scan */
+            streamSample(XYcordinates);
+
+            if (0u != firstScan)
+            {
+                firstScan = 0u;
+                if (0u != warmBoot)
+                {
+                    appCounters.warmFirstScanMs = appTimerNow();
+                }
+                else
+                {
+                    appCounters.coldFirstScanMs = appTimerNow();
+                }
+                DBGLOG(Info, "%s boot, first scan after %lu ms (cold %lu ms, warm %lu ms)",
+                       (0u != warmBoot) ? "warm" : "cold", appTimerNow(),
+                       appCounters.coldFirstScanMs, appCounters.warmFirstScanMs);
+            }
+
+            /* Keep IPC queue, counters and baselines for a warm restart */
+            warmBootUpdate();
+
             /* Required to maintain sychronization with tuner interface */
             CapSense_RunTuner();
 
+            /* Switch HFCLK between scans only */
+            clockGovernorUpdate(XYcordinates != CapSense_TOUCHPAD_NO_TOUCH);
+
             /* Initiates the next scan of all widgets */
             CapSense_ScanAllWidgets();
         }
 
+        /* Sends queued messages to EZ-BLE™ PRoC™ Module */
+        streamProcess();
+        ipcProcess();
+
         uint32 ch = UART_UartGetChar();
         if (0u != ch)
         {
             UART_UartPutChar(ch);
+
+            /* 's' toggles the trackpad stream */
+            if ('s' == ch)
+            {
+                streamEnable(0u == streamIsEnabled());
+            }
         }
 
         // CyDelay(5000u);
@@ -0,0 +1,281 @@
+/* ========================================
+ *
+ * Stand-in for the phone app: decodes the launcher messages the EZ-BLE
+ * bridge broadcasts in its advertising data (see app_Broadcast.h).
+ *
+ * Reads advertising data as hex, one advertisement per line, e.g. the
+ * "Data:" lines of btmon or a test vector, and prints every new message
+ * with a valid tag. Repeats of a sequence number are reported once.
+ * The key and company id are the ones provisioned in the bridge, the key
+ * as the 16 bytes it takes in the SFlash row.
+ *
+ *   broadcast_decoder <company id> <key hex> < adv.txt
+ *   broadcast_decoder <company id> <key hex> -e <sequence> <message hex>
+ *   broadcast_decoder <company id> <key hex> -p   SFlash provisioning row
+ *
+ * ========================================
+*/
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define BROADCAST_VERSION 1u
+#define BROADCAST_PROVISION_MAGIC 0x59454B42u
+#define BROADCAST_KEY_SIZE 16u
+#define BROADCAST_AD_TYPE 0xFFu
+#define BROADCAST_TAG_SIZE 4u
+#define IPC_MESSAGE_SIZE 4u
+#define BROADCAST_RECORD_SIZE (2u + 2u + 1u + 2u + IPC_MESSAGE_SIZE + BROADCAST_TAG_SIZE)
+#define ADV_DATA_LEN_MAX 31u
+
+#define XTEA_ROUNDS 32u
+#define XTEA_DELTA 0x9E3779B9u
+
+static uint32_t broadcastKey[4];
+static unsigned companyId;
+
+static void xteaEncipher(uint32_t v[2])
+{
+	uint32_t v0 = v[0];
+	uint32_t v1 = v[1];
+	uint32_t sum = 0u;
+	unsigned i;
+
+	for (i = 0; i < XTEA_ROUNDS; i++)
+	{
+		v0 += (((v1 << 4) ^ (v1 >> 5)) + v1) ^ (sum + broadcastKey[sum & 3u]);
+		sum += XTEA_DELTA;
+		v1 += (((v0 << 4) ^ (v0 >> 5)) + v0) ^ (sum + broadcastKey[(sum >> 11) & 3u]);
+	}
+	v[0] = v0;
+	v[1] = v1;
+}
+
+/* XTEA CBC-MAC truncated to BROADCAST_TAG_SIZE bytes */
+static void broadcastTag(const uint8_t *data, unsigned len, uint8_t *tag)
+{
+	uint32_t v[2] = {0u, 0u};
+	unsigned i;
+
+	for (i = 0; i < len; i++)
+	{
+		v[(i & 7u) >> 2] ^= (uint32_t)data[i] << (8u * (i & 3u));
+		if ((7u == (i & 7u)) || ((i + 1u) == len))
+		{
+			xteaEncipher(v);
+		}
+	}
+
+	for (i = 0; i < BROADCAST_TAG_SIZE; i++)
+	{
+		tag[i] = (uint8_t)(v[0] >> (8u * i));
+	}
+}
+
+/* Parses hex digits, separators between bytes are ignored */
+static unsigned parseHex(const char *text, uint8_t *data, unsigned size)
+{
+	unsigned len = 0;
+	int nibble = -1;
+
+	for (; *text != '\0'; text++)
+	{
+		int digit;
+
+		if ((*text >= '0') && (*text <= '9'))
+			digit = *text - '0';
+		else if ((*text >= 'a') && (*text <= 'f'))
+			digit = *text - 'a' + 10;
+		else if ((*text >= 'A') && (*text <= 'F'))
+			digit = *text - 'A' + 10;
+		else
+		{
+			nibble = -1;
+			continue;
+		}
+
+		if (nibble < 0)
+		{
+			nibble = digit;
+		}
+		else
+		{
+			if (len < size)
+				data[len] = (uint8_t)((nibble << 4) | digit);
+			len++;
+			nibble = -1;
+		}
+	}
+	return len;
+}
+
+static int encode(unsigned sequence, const char *message)
+{
+	uint8_t record[BROADCAST_RECORD_SIZE];
+	unsigned i;
+
+	record[0] = BROADCAST_RECORD_SIZE - 1u;
+	record[1] = BROADCAST_AD_TYPE;
+	record[2] = companyId & 0xFFu;
+	record[3] = companyId >> 8;
+	record[4] = BROADCAST_VERSION;
+	record[5] = sequence & 0xFFu;
+	record[6] = (sequence >> 8) & 0xFFu;
+	if (IPC_MESSAGE_SIZE != parseHex(message, &record[7], IPC_MESSAGE_SIZE))
+	{
+		fprintf(stderr, "message must be %u bytes\n", IPC_MESSAGE_SIZE);
+		return 1;
+	}
+	broadcastTag(record, BROADCAST_RECORD_SIZE - BROADCAST_TAG_SIZE, &record[BROADCAST_RECORD_SIZE - BROADCAST_TAG_SIZE]);
+
+	/* Flags record in front, like the BLE component puts it */
+	printf("02 01 06");
+	for (i = 0; i < BROADCAST_RECORD_SIZE; i++)
+		printf(" %02X", record[i]);
+	printf("\n");
+	return 0;
+}
+
+/* Returns 1 for a message, 0 if there is none, -1 for a bad tag */
+static int decodeRecord(const uint8_t *record, unsigned len, unsigned *sequence, int *event, int *value)
+{
+	uint8_t tag[BROADCAST_TAG_SIZE];
+
+	if ((BROADCAST_RECORD_SIZE != len) || (BROADCAST_AD_TYPE != record[1]) ||
+		((unsigned)(record[2] | (record[3] << 8)) != companyId) || (BROADCAST_VERSION != record[4]))
+	{
+		return 0;
+	}
+
+	broadcastTag(record, BROADCAST_RECORD_SIZE - BROADCAST_TAG_SIZE, tag);
+	if (0 != memcmp(tag, &record[BROADCAST_RECORD_SIZE - BROADCAST_TAG_SIZE], BROADCAST_TAG_SIZE))
+	{
+		return -1;
+	}
+
+	*sequence = record[5] | (record[6] << 8);
+	*event = (int16_t)(record[7] | (record[8] << 8));
+	*value = (int16_t)(record[9] | (record[10] << 8));
+	return 1;
+}
+
+static int decode(FILE *in)
+{
+	char line[512];
+	long lastSequence = -1;
+	int errors = 0;
+
+	while (NULL != fgets(line, sizeof(line), in))
+	{
+		uint8_t adv[ADV_DATA_LEN_MAX];
+		unsigned len = parseHex(line, adv, sizeof(adv));
+		unsigned i;
+
+		if (len > ADV_DATA_LEN_MAX)
+		{
+			fprintf(stderr, "skipped, longer than %u bytes\n", ADV_DATA_LEN_MAX);
+			continue;
+		}
+
+		/* Walk the [length][type][data] records */
+		for (i = 0; (i + 1u) < len; i += adv[i] + 1u)
+		{
+			unsigned sequence;
+			int event;
+			int value;
+			int result;
+
+			if ((0u == adv[i]) || ((i + adv[i] + 1u) > len))
+				break;
+
+			result = decodeRecord(&adv[i], adv[i] + 1u, &sequence, &event, &value);
+			if (result < 0)
+			{
+				printf("bad tag\n");
+				errors++;
+			}
+			else if ((result > 0) && ((long)sequence != lastSequence))
+			{
+				lastSequence = sequence;
+				printf("sequence %u event %d value %d\n", sequence, event, value);
+			}
+		}
+	}
+	return (0 == errors) ? 0 : 2;
+}
+
+/* Prints the BROADCAST_PROVISION_T the bridge expects in its SFlash row */
+static int provision(void)
+{
+	uint8_t row[8u + BROADCAST_KEY_SIZE];
+	unsigned i;
+
+	for (i = 0; i < 4u; i++)
+		row[i] = (uint8_t)(BROADCAST_PROVISION_MAGIC >> (8u * i));
+	row[4] = companyId & 0xFFu;
+	row[5] = companyId >> 8;
+	row[6] = 0u;
+	row[7] = 0u;
+	for (i = 0; i < BROADCAST_KEY_SIZE; i++)
+		row[8u + i] = (uint8_t)(broadcastKey[i >> 2] >> (8u * (i & 3u)));
+
+	for (i = 0; i < sizeof(row); i++)
+		printf((0u == i) ? "%02X" : " %02X", row[i]);
+	printf("\n");
+	return 0;
+}
+
+/* Takes the company id and the key, like the bridge reads them */
+static int setProvision(const char *company, const char *key)
+{
+	uint8_t bytes[BROADCAST_KEY_SIZE];
+	char *end;
+	unsigned i;
+
+	companyId = (unsigned)strtoul(company, &end, 0);
+	if (('\0' != *end) || (companyId > 0xFFFFu))
+	{
+		fprintf(stderr, "company id must be 16 bits\n");
+		return 1;
+	}
+	if (BROADCAST_KEY_SIZE != parseHex(key, bytes, sizeof(bytes)))
+	{
+		fprintf(stderr, "key must be %u bytes\n", BROADCAST_KEY_SIZE);
+		return 1;
+	}
+	for (i = 0; i < BROADCAST_KEY_SIZE; i++)
+		broadcastKey[i >> 2] |= (uint32_t)bytes[i] << (8u * (i & 3u));
+	if (0u == (broadcastKey[0] | broadcastKey[1] | broadcastKey[2] | broadcastKey[3]))
+	{
+		fprintf(stderr, "an all zero key is not provisioned\n");
+		return 1;
+	}
+	return 0;
+}
+
+int main(int argc, char *argv[])
+{
+	if ((argc < 3) || (0 != setProvision(argv[1], argv[2])))
+	{
+		fprintf(stderr, "usage: %s <company id> <key hex> < adv.txt\n"
+						"       %s <company id> <key hex> -e <sequence> <message hex>\n"
+						"       %s <company id> <key hex> -p\n",
+				argv[0], argv[0], argv[0]);
+		return 1;
+	}
+	if ((argc == 6) && (0 == strcmp(argv[3], "-e")))
+	{
+		return encode((unsigned)strtoul(argv[4], NULL, 0), argv[5]);
+	}
+	if ((argc == 4) && (0 == strcmp(argv[3], "-p")))
+	{
+		return provision();
+	}
+	if (argc != 3)
+	{
+		fprintf(stderr, "usage: %s <company id> <key hex> < adv.txt\n", argv[0]);
+		return 1;
+	}
+	return decode(stdin);
+}
@@ -0,0 +1,820 @@
+/* ========================================
+ *
+ * Scripted test bench for the host build of the bridge. The script plays
+ * the phone (connect, CCCD, RX writes, credits, MTU, stack buffers) and the
+ * launcher (launch messages, trackpad stream frames, reads of the read
+ * buffer and the register file), then checks the measured numbers.
+ *
+ * usage: host_bench [-v] script
+ *
+ * Every line is one command, '#' starts a comment:
+ *   connect [interval_ms]       phone connects, the bridge must advertise
+ *   disconnect
+ *   mtu <size>                  phone exchanges the ATT MTU
+ *   cccd 0|1                    phone writes the TX CCCD
+ *   rx <hex>                    phone writes RX, e.g. rx 01 02 03
+ *   credit <n>                  phone grants n frames (CREDIT_FLOW)
+ *   autocredit <n>              phone grants n frames again every n received, 0 stops
+ *   buffers <n> [per_event]     stack buffers and notifications per connection event
+ *   l2cap accept|reject         phone answer to connection parameter requests
+ *   launch                      launcher writes EventLaunchApp(AppVoiceAssistant)
+ *   frames <n> <period_ms> <size>  launcher streams n trackpad frames
+ *   pace on|off                 launcher holds frames the bridge has no room for
+ *   read                        launcher reads the read buffer
+ *   regs                        launcher reads the register file
+ *   stall <ms>                  the bridge main loop hangs in the stack, the launcher goes on
+ *   wait <ms>
+ *   waitfor advertising|connected|notify <timeout_ms>
+ *   drain <timeout_ms>          until every frame is written and sent
+ *   report                      print the metrics
+ *   reset                       start measuring again
+ *   expect <metric> <op> <value>  op is one of < <= == >= > !=
+ *
+ * ========================================
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "bench.h"
+#include "main.h"
+
+#define SCRIPT_LINES 256u
+#define SCRIPT_LINE_SIZE 160u
+#define CONTROL_DEPTH 16u
+#define LAUNCH_DEPTH 64u
+#define FRAME_SEQUENCES 65536u
+#define FRAME_HEADER 8u /* [event:2][sequence:2][write time:4] */
+
+/* Launcher pacing, as the launcher firmware does with the register file */
+#define PACE_RESERVE 2u
+#define PACE_POLL_MS 20u
+
+typedef enum
+{
+	OpWrite,
+	OpRead,
+	OpRegs
+} OP_T;
+
+typedef struct
+{
+	uint8 op;
+	uint8 len;
+	uint8 data[I2C_WRITE_BUFFER_SIZE];
+} CONTROL_T;
+
+typedef enum
+{
+	WaitNone,
+	WaitTime,
+	WaitAdvertising,
+	WaitConnected,
+	WaitNotify,
+	WaitDrain
+} WAIT_T;
+
+static char script[SCRIPT_LINES][SCRIPT_LINE_SIZE];
+static uint32 scriptLines;
+static uint32 scriptLine;
+static const char *scriptName;
+static uint8 wait = WaitNone;
+static uint64_t waitUntil = SIM_NEVER;
+static uint32 failures;
+
+/* Launcher side */
+static CONTROL_T control[CONTROL_DEPTH];
+static uint8 controlHead;
+static uint8 controlCount;
+static CONTROL_T busOp;	 /* transfer on the bus */
+static uint64_t busDone = SIM_NEVER;
+static uint32 framesLeft;
+static uint32 framePeriod; /* ticks */
+static uint8 frameSize;
+static uint64_t frameNext = SIM_NEVER;
+static uint16 frameSequence;
+static uint8 pace;
+static uint8 paceCredits;
+static uint8 pacePolling;
+static uint8 frameHeld; /* the next frame was held */
+static uint64_t paceNext;
+static I2C_REG_FILE_T regs;
+static uint8 readData[I2C_READ_BUFFER_SIZE];
+
+/* Phone side */
+static uint8 autoCredit;
+static uint32 creditReceived;
+
+/* Metrics, since the last reset */
+static struct
+{
+	uint64_t start;
+	uint64_t last;	   /* last frame received */
+	uint32 written;	   /* trackpad frames written by the launcher */
+	uint32 received;   /* trackpad frames notified to the phone */
+	uint32 duplicates; /* trackpad frames notified twice */
+	uint32 merged;	   /* trackpad frames notified with another length than written */
+	uint32 held;	   /* frames the launcher held for lack of room */
+	uint64_t latencySum;
+	uint64_t latencyMax;
+	uint32 launches;
+	uint32 launchesReceived;
+	uint64_t launchMax;
+	uint32 dropBase; /* bridge drop counters at the reset */
+	uint32 overrunBase;
+	uint32 busyBase;
+	uint32 reads;
+	uint32 regReads;
+} m;
+
+static uint64_t launchTime[LAUNCH_DEPTH];
+static uint8 launchHead;
+static uint8 launchCount;
+static uint8 seen[FRAME_SEQUENCES / 8u];
+
+/* Bridge drop counters, everything the bridge knows it did not send */
+static uint32 bridgeDrops(void)
+{
+	return i2cStats.dropped + ntfStats.dropped + ntfStats.expired + ntfStats.oversize;
+}
+
+static uint64_t transferTicks(uint32 bytes)
+{
+	uint64_t ticks = ((uint64_t)bytes * SIM_I2C_BYTE_NS * SIM_HZ) / 1000000000u;
+
+	return (0u != ticks) ? ticks : 1u;
+}
+
+static void benchReset(void)
+{
+	memset(&m, 0, sizeof(m));
+	memset(seen, 0, sizeof(seen));
+	m.start = simNow;
+	m.dropBase = bridgeDrops();
+	m.overrunBase = simStats.i2cOverruns;
+	simStats.i2cWritesPerPass = 0u;
+	m.busyBase = ntfStats.busy;
+	launchCount = 0u;
+}
+
+static double metric(const char *name)
+{
+	uint32 lost = m.written - m.received;
+
+	if (0 == strcmp(name, "written"))
+		return m.written;
+	if (0 == strcmp(name, "received"))
+		return m.received;
+	if (0 == strcmp(name, "duplicates"))
+		return m.duplicates;
+	if (0 == strcmp(name, "merged"))
+		return m.merged;
+	if (0 == strcmp(name, "lost"))
+		return lost;
+	if (0 == strcmp(name, "dropped"))
+		return bridgeDrops() - m.dropBase;
+	if (0 == strcmp(name, "silent"))
+		return (double)lost - (double)(bridgeDrops() - m.dropBase);
+	if (0 == strcmp(name, "held"))
+		return m.held;
+	if (0 == strcmp(name, "fps"))
+		return (m.last > m.start) ? (m.received / (SIM_TO_MS(m.last - m.start) / 1000.0)) : 0.0;
+	if (0 == strcmp(name, "latency_avg_ms"))
+		return (0u != m.received) ? SIM_TO_MS(m.latencySum) / m.received : 0.0;
+	if (0 == strcmp(name, "latency_max_ms"))
+		return SIM_TO_MS(m.latencyMax);
+	if (0 == strcmp(name, "launches"))
+		return m.launchesReceived;
+	if (0 == strcmp(name, "launch_max_ms"))
+		return SIM_TO_MS(m.launchMax);
+	if (0 == strcmp(name, "adv_restart_ms"))
+		return (SIM_NEVER != simStats.advRestartTicks) ? SIM_TO_MS(simStats.advRestartTicks) : -1.0;
+	if (0 == strcmp(name, "overruns"))
+		return simStats.i2cOverruns - m.overrunBase;
+	if (0 == strcmp(name, "writes_per_pass"))
+		return simStats.i2cWritesPerPass;
+	if (0 == strcmp(name, "busy"))
+		return ntfStats.busy - m.busyBase;
+	if (0 == strcmp(name, "queued"))
+		return notificationQueued();
+	if (0 == strcmp(name, "credits"))
+		return regs.credits;
+	if (0 == strcmp(name, "ntf_free"))
+		return regs.ntfFree;
+	if (0 == strcmp(name, "state"))
+		return regs.state;
+	if (0 == strcmp(name, "data_ready"))
+		return simStats.dataReady;
+	if (0 == strcmp(name, "read0"))
+		return readData[0];
+	if (0 == strcmp(name, "adv_starts"))
+		return simStats.advStarts;
+	if (0 == strcmp(name, "link_updates"))
+		return simStats.linkUpdates;
+	if (0 == strcmp(name, "ready_ms"))
+		return bondStats.readyMs;
+	if (0 == strcmp(name, "bonded_connects"))
+		return bondStats.bondedConnects;
+
+	fprintf(stderr, "%s:%u: unknown metric %s\n", scriptName, (unsigned)scriptLine, name);
+	exit(2);
+}
+
+static void report(void)
+{
+	static const char *const names[] = {"written", "received", "lost", "dropped", "silent", "held", "fps",
+										"latency_avg_ms", "latency_max_ms", "launches", "launch_max_ms",
+										"adv_restart_ms", "overruns", "busy", "queued"};
+	uint32 i;
+
+	printf("%10.3f ms  report:", SIM_TO_MS(simNow));
+	for (i = 0u; i < sizeof(names) / sizeof(names[0]); i++)
+	{
+		printf(" %s=%.6g", names[i], metric(names[i]));
+	}
+	printf("\n");
+}
+
+static void expect(const char *name, const char *op, double value)
+{
+	double actual = metric(name);
+	int ok;
+
+	if (0 == strcmp(op, "<"))
+		ok = actual < value;
+	else if (0 == strcmp(op, "<="))
+		ok = actual <= value;
+	else if (0 == strcmp(op, "=="))
+		ok = actual == value;
+	else if (0 == strcmp(op, ">="))
+		ok = actual >= value;
+	else if (0 == strcmp(op, ">"))
+		ok = actual > value;
+	else if (0 == strcmp(op, "!="))
+		ok = actual != value;
+	else
+	{
+		fprintf(stderr, "%s:%u: unknown operator %s\n", scriptName, (unsigned)scriptLine, op);
+		exit(2);
+	}
+
+	if (!ok)
+	{
+		failures++;
+		printf("%s:%u: expect %s %s %g failed, got %g\n", scriptName, (unsigned)scriptLine, name, op, value, actual);
+	}
+	else if (0 != simVerbose)
+	{
+		printf("%s:%u: %s = %g\n", scriptName, (unsigned)scriptLine, name, actual);
+	}
+}
+
+static void queueControl(uint8 op, const uint8 *data, uint8 len)
+{
+	CONTROL_T *entry;
+
+	if (controlCount >= CONTROL_DEPTH)
+	{
+		fprintf(stderr, "%s:%u: too many launcher transfers queued\n", scriptName, (unsigned)scriptLine);
+		exit(2);
+	}
+	entry = &control[(controlHead + controlCount) % CONTROL_DEPTH];
+	entry->op = op;
+	entry->len = len;
+	if (NULL != data)
+	{
+		memcpy(entry->data, data, len);
+	}
+	controlCount++;
+}
+
+static void phoneCredit(uint8 frames)
+{
+	uint8 value[RX_CREDIT_SIZE] = {RX_CREDIT_TAG, frames};
+
+	simWrite(CYBLE_VOICE_ASSISTANT_LAUNCHER_RXCHARACTERISTIC_CHAR_HANDLE, value, sizeof(value), 0u);
+}
+
+/* Parses hex bytes, spaces between bytes are optional */
+static uint8 parseHex(const char *text, uint8 *data, uint8 size)
+{
+	uint8 len = 0u;
+	unsigned byte;
+
+	while (len < size)
+	{
+		while (' ' == *text)
+		{
+			text++;
+		}
+		if (1 != sscanf(text, "%2x", &byte))
+		{
+			break;
+		}
+		data[len++] = (uint8)byte;
+		text += ((' ' != text[1]) && ('\0' != text[1])) ? 2 : 1;
+	}
+	return len;
+}
+
+static void fail(const char *message)
+{
+	fprintf(stderr, "%s:%u: %s\n", scriptName, (unsigned)scriptLine, message);
+	exit(2);
+}
+
+/* Runs one script line, returns 0 once the script waits */
+static int command(char *line)
+{
+	char word[32] = "";
+	char arg[32] = "";
+	char op[8] = "";
+	double value = 0.0;
+	unsigned a = 0u;
+	unsigned b = 0u;
+	unsigned c = 0u;
+	int n;
+	uint8 data[I2C_WRITE_BUFFER_SIZE];
+
+	if (1 != sscanf(line, "%31s%n", word, &n))
+	{
+		return 1;
+	}
+	line += n;
+
+	if (0 != simVerbose)
+	{
+		printf("%10.3f ms  %s%s\n", SIM_TO_MS(simNow), word, line);
+	}
+
+	if (0 == strcmp(word, "connect"))
+	{
+		a = SIM_INTERVAL_MS;
+		(void)sscanf(line, "%u", &a);
+		if (0 == simConnect(a))
+		{
+			fail("connect while not advertising");
+		}
+	}
+	else if (0 == strcmp(word, "disconnect"))
+	{
+		if (0 == simDisconnect())
+		{
+			fail("disconnect while not connected");
+		}
+	}
+	else if ((0 == strcmp(word, "mtu")) && (1 == sscanf(line, "%u", &a)))
+	{
+		simMtu((uint16)a);
+	}
+	else if ((0 == strcmp(word, "cccd")) && (1 == sscanf(line, "%u", &a)))
+	{
+		data[0] = (uint8)a;
+		data[1] = 0u;
+		simWrite(CYBLE_VOICE_ASSISTANT_LAUNCHER_TXCHARACTERISTIC_CLIENT_CHARACTERISTIC_CONFIGURATION_DESC_HANDLE, data, 2u, 1u);
+	}
+	else if (0 == strcmp(word, "rx"))
+	{
+		simWrite(CYBLE_VOICE_ASSISTANT_LAUNCHER_RXCHARACTERISTIC_CHAR_HANDLE, data, parseHex(line, data, sizeof(data)), 1u);
+	}
+	else if ((0 == strcmp(word, "credit")) && (1 == sscanf(line, "%u", &a)))
+	{
+		phoneCredit((uint8)a);
+	}
+	else if ((0 == strcmp(word, "autocredit")) && (1 == sscanf(line, "%u", &a)))
+	{
+		autoCredit = (uint8)a;
+		creditReceived = 0u;
+	}
+	else if ((0 == strcmp(word, "buffers")) && (1 <= sscanf(line, "%u %u", &a, &b)))
+	{
+		simStackBuffers((uint8)a, (uint8)((0u != b) ? b : SIM_PACKETS_PER_EVENT));
+	}
+	else if ((0 == strcmp(word, "l2cap")) && (1 == sscanf(line, "%31s", arg)))
+	{
+		simLinkUpdates(0 == strcmp(arg, "accept"));
+	}
+	else if (0 == strcmp(word, "launch"))
+	{
+		data[0] = IPC_EVENT_LAUNCH_APP;
+		data[1] = 0u;
+		data[2] = IPC_APP_VOICE_ASSISTANT;
+		data[3] = 0u;
+		queueControl(OpWrite, data, IPC_MESSAGE_SIZE);
+	}
+	else if ((0 == strcmp(word, "frames")) && (3 == sscanf(line, "%u %u %u", &a, &b, &c)))
+	{
+		if ((c < FRAME_HEADER) || (c > I2C_WRITE_BUFFER_SIZE))
+		{
+			fail("frame size out of range");
+		}
+		framesLeft = a;
+		framePeriod = (uint32)SIM_MS(b);
+		frameSize = (uint8)c;
+		frameNext = simNow;
+	}
+	else if ((0 == strcmp(word, "pace")) && (1 == sscanf(line, "%31s", arg)))
+	{
+		pace = (0 == strcmp(arg, "on"));
+		paceCredits = 0u;
+		paceNext = simNow;
+	}
+	else if (0 == strcmp(word, "read"))
+	{
+		queueControl(OpRead, NULL, I2C_READ_BUFFER_SIZE);
+	}
+	else if (0 == strcmp(word, "regs"))
+	{
+		queueControl(OpRegs, NULL, sizeof(I2C_REG_FILE_T));
+	}
+	else if ((0 == strcmp(word, "stall")) && (1 == sscanf(line, "%u", &a)))
+	{
+		simAdvance(SIM_MS(a));
+	}
+	else if ((0 == strcmp(word, "wait")) && (1 == sscanf(line, "%u", &a)))
+	{
+		wait = WaitTime;
+		waitUntil = simNow + SIM_MS(a);
+		return 0;
+	}
+	else if ((0 == strcmp(word, "waitfor")) && (2 == sscanf(line, "%31s %u", arg, &a)))
+	{
+		if (0 == strcmp(arg, "advertising"))
+			wait = WaitAdvertising;
+		else if (0 == strcmp(arg, "connected"))
+			wait = WaitConnected;
+		else if (0 == strcmp(arg, "notify"))
+			wait = WaitNotify;
+		else
+			fail("unknown condition");
+		waitUntil = simNow + SIM_MS(a);
+		return 0;
+	}
+	else if ((0 == strcmp(word, "drain")) && (1 == sscanf(line, "%u", &a)))
+	{
+		wait = WaitDrain;
+		waitUntil = simNow + SIM_MS(a);
+		return 0;
+	}
+	else if (0 == strcmp(word, "report"))
+	{
+		report();
+	}
+	else if (0 == strcmp(word, "reset"))
+	{
+		benchReset();
+	}
+	else if ((0 == strcmp(word, "expect")) && (3 == sscanf(line, "%31s %7s %lf", arg, op, &value)))
+	{
+		expect(arg, op, value);
+	}
+	else
+	{
+		fail("bad command");
+	}
+	return 1;
+}
+
+/* Returns 1 once the condition the script waits for is met */
+static int waitDone(void)
+{
+	switch (wait)
+	{
+	case WaitAdvertising:
+		return CYBLE_STATE_ADVERTISING == cyBle_state;
+	case WaitConnected:
+		return CYBLE_STATE_CONNECTED == cyBle_state;
+	case WaitNotify:
+		return 0u != sendNotifications;
+	case WaitDrain:
+		return (0u == framesLeft) && (0u == controlCount) && (SIM_NEVER == busDone) && (0u == eventPending()) &&
+			   (0u == notificationQueued()) && (0u == simLinkQueued());
+	default:
+		return 0;
+	}
+}
+
+static void runScript(void)
+{
+	if (WaitNone != wait)
+	{
+		if ((WaitTime != wait) && (0 != waitDone()))
+		{
+			wait = WaitNone;
+		}
+		else if (simNow >= waitUntil)
+		{
+			if (WaitTime != wait)
+			{
+				printf("%s:%u: timed out\n", scriptName, (unsigned)scriptLine);
+				failures++;
+			}
+			wait = WaitNone;
+		}
+		else
+		{
+			return;
+		}
+	}
+
+	while (scriptLine < scriptLines)
+	{
+		if (0 == command(script[scriptLine++]))
+		{
+			return;
+		}
+	}
+
+	printf("%s: %s\n", scriptName, (0u == failures) ? "PASS" : "FAIL");
+	exit((0u == failures) ? 0 : 1);
+}
+
+/* Completes the transfer on the bus */
+static void finishTransfer(void)
+{
+	uint8 select = 0u;
+
+	switch (busOp.op)
+	{
+	case OpWrite:
+		if ((FRAME_HEADER <= busOp.len) && (IPC_EVENT_TRACKPAD_STREAM == busOp.data[0]))
+		{
+			/* The frame carries the time it reached the bridge */
+			uint32 time = (uint32)simNow;
+
+			memcpy(&busOp.data[4], &time, sizeof(time));
+			m.written++;
+		}
+		else if ((IPC_MESSAGE_SIZE == busOp.len) && (IPC_EVENT_LAUNCH_APP == busOp.data[0]))
+		{
+			if (launchCount < LAUNCH_DEPTH)
+			{
+				launchTime[(launchHead + launchCount) % LAUNCH_DEPTH] = simNow;
+				launchCount++;
+			}
+			m.launches++;
+		}
+		simI2CWrite(busOp.data, busOp.len);
+		break;
+
+	case OpRead:
+		simI2CRead(readData, busOp.len);
+		m.reads++;
+		if (0 != simVerbose)
+		{
+			printf("%10.3f ms  read %02X %02X %02X %02X ...\n", SIM_TO_MS(simNow), readData[0], readData[1], readData[2], readData[3]);
+		}
+		break;
+
+	case OpRegs:
+		simI2CWriteRead(&select, sizeof(select), (uint8 *)&regs, busOp.len);
+		m.regReads++;
+		if (0u != pacePolling)
+		{
+			pacePolling = 0u;
+			paceCredits = (regs.ntfFree > PACE_RESERVE) ? (uint8)(regs.ntfFree - PACE_RESERVE) : 0u;
+			paceNext = simNow + SIM_MS(PACE_POLL_MS);
+		}
+		if (0 != simVerbose)
+		{
+			printf("%10.3f ms  regs v%u state %02X queued %u free %u mtu %u credits %u\n", SIM_TO_MS(simNow),
+				   regs.version, regs.state, regs.ntfQueued, regs.ntfFree, regs.mtu, regs.credits);
+		}
+		break;
+
+	default:
+		break;
+	}
+	busDone = SIM_NEVER;
+}
+
+/* Starts the next launcher transfer, control transfers go ahead of frames */
+static void startTransfer(void)
+{
+	uint32 bytes;
+
+	if (0u != controlCount)
+	{
+		busOp = control[controlHead];
+		controlHead = (controlHead + 1u) % CONTROL_DEPTH;
+		controlCount--;
+	}
+	else if ((0u != framesLeft) && (simNow >= frameNext))
+	{
+		if ((0u != pace) && (0u == paceCredits))
+		{
+			/* Hold the frame and ask the bridge for room now and then */
+			if (0u == frameHeld)
+			{
+				frameHeld = 1u;
+				m.held++;
+			}
+			if (simNow < paceNext)
+			{
+				return;
+			}
+			pacePolling = 1u;
+			busOp.op = OpRegs;
+			busOp.len = sizeof(I2C_REG_FILE_T);
+		}
+		else
+		{
+			busOp.op = OpWrite;
+			busOp.len = frameSize;
+			memset(busOp.data, 0xA5, frameSize);
+			busOp.data[0] = IPC_EVENT_TRACKPAD_STREAM;
+			busOp.data[1] = 0u;
+			busOp.data[2] = (uint8)frameSequence;
+			busOp.data[3] = (uint8)(frameSequence >> 8);
+			frameSequence++;
+			frameHeld = 0u;
+			framesLeft--;
+			frameNext += framePeriod;
+			if (0u != paceCredits)
+			{
+				paceCredits--;
+			}
+		}
+	}
+	else
+	{
+		return;
+	}
+
+	switch (busOp.op)
+	{
+	case OpRegs:
+		bytes = 2u + 1u + busOp.len; /* address, register, repeated start address, data */
+		break;
+	default:
+		bytes = 1u + busOp.len;
+		break;
+	}
+	busDone = simNow + transferTicks(bytes);
+}
+
+uint64_t benchNextDue(void)
+{
+	uint64_t due = waitUntil;
+
+	if (WaitNone == wait)
+	{
+		return simNow;
+	}
+	if (busDone < due)
+	{
+		due = busDone;
+	}
+	else if (SIM_NEVER == busDone)
+	{
+		if (0u != controlCount)
+		{
+			return simNow;
+		}
+		if (0u != framesLeft)
+		{
+			uint64_t next = frameNext;
+
+			if ((0u != pace) && (0u == paceCredits) && (paceNext > next))
+			{
+				next = paceNext;
+			}
+			if (next < due)
+			{
+				due = next;
+			}
+		}
+	}
+	return due;
+}
+
+/* Drives the bus on the launcher clock, whenever simulated time moves */
+void benchBus(void)
+{
+	if (simNow >= busDone)
+	{
+		finishTransfer();
+	}
+	if ((SIM_NEVER == busDone) && (0 != simI2CReady()))
+	{
+		startTransfer();
+	}
+}
+
+void benchRun(void)
+{
+	/* The script sees what the bridge made of the last transfer */
+	runScript();
+	benchBus();
+}
+
+void benchNotified(const uint8 *value, uint16 len)
+{
+	uint16 offset = 0u;
+
+	/* [length][frame] records with NOTIFY_PACKING, one frame without */
+	while (offset < len)
+	{
+#ifdef NOTIFY_PACKING
+		uint8 size = value[offset++];
+#else
+		uint8 size = (uint8)len;
+#endif /* NOTIFY_PACKING */
+		const uint8 *frame = &value[offset];
+
+		if ((offset + size) > len)
+		{
+			printf("%10.3f ms  bad record, %u bytes left for %u\n", SIM_TO_MS(simNow), (unsigned)(len - offset), size);
+			failures++;
+			return;
+		}
+		offset += size;
+
+		if ((FRAME_HEADER <= size) && (IPC_EVENT_TRACKPAD_STREAM == frame[0]))
+		{
+			uint16 sequence = (uint16)(frame[2] | ((uint16)frame[3] << 8));
+			uint32 time;
+			uint64_t latency;
+
+			memcpy(&time, &frame[4], sizeof(time));
+			latency = (uint32)((uint32)simNow - time);
+
+			if (0u != (seen[sequence / 8u] & (1u << (sequence % 8u))))
+			{
+				m.duplicates++;
+				continue;
+			}
+			if (size != frameSize)
+			{
+				m.merged++;
+			}
+			seen[sequence / 8u] |= (uint8)(1u << (sequence % 8u));
+			m.received++;
+			m.last = simNow;
+			m.latencySum += latency;
+			if (latency > m.latencyMax)
+			{
+				m.latencyMax = latency;
+			}
+		}
+		else if ((IPC_MESSAGE_SIZE == size) && (IPC_EVENT_LAUNCH_APP == frame[0]) && (0u != launchCount))
+		{
+			uint64_t latency = simNow - launchTime[launchHead];
+
+			launchHead = (launchHead + 1u) % LAUNCH_DEPTH;
+			launchCount--;
+			m.launchesReceived++;
+			if (latency > m.launchMax)
+			{
+				m.launchMax = latency;
+			}
+		}
+
+		if (0u != autoCredit)
+		{
+			creditReceived++;
+			if (creditReceived >= autoCredit)
+			{
+				creditReceived = 0u;
+				phoneCredit(autoCredit);
+			}
+		}
+	}
+}
+
+int main(int argc, char **argv)
+{
+	FILE *file;
+	int arg = 1;
+
+	if ((argc > arg) && (0 == strcmp(argv[arg], "-v")))
+	{
+		simVerbose = 1;
+		arg++;
+	}
+	if (argc != (arg + 1))
+	{
+		fprintf(stderr, "usage: %s [-v] script\n", argv[0]);
+		return 2;
+	}
+
+	scriptName = argv[arg];
+	file = fopen(scriptName, "r");
+	if (NULL == file)
+	{
+		perror(scriptName);
+		return 2;
+	}
+	while ((scriptLines < SCRIPT_LINES) && (NULL != fgets(script[scriptLines], SCRIPT_LINE_SIZE, file)))
+	{
+		script[scriptLines][strcspn(script[scriptLines], "#\r\n")] = '\0';
+		scriptLines++;
+	}
+	fclose(file);
+
+	simStats.advRestartTicks = SIM_NEVER;
+	benchReset();
+
+	/* Runs until the script ends */
+	bridgeMain();
+	return 2;
+}
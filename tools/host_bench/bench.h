@@ -0,0 +1,86 @@
+/* ========================================
+ *
+ * Interface between the simulated hardware (hal.c) and the scripted test
+ * bench (bench.c). Time is counted in ticks of the WDT counter the bridge
+ * uses as time base (APP_TIMER_HZ).
+ *
+ * ========================================
+*/
+#pragma once
+#include <stdint.h>
+#include "project.h"
+
+#define SIM_HZ 32768u
+#define SIM_MS(ms) ((uint64_t)(ms) * SIM_HZ / 1000u)
+#define SIM_TO_MS(ticks) ((double)(ticks) * 1000.0 / SIM_HZ)
+#define SIM_NEVER UINT64_MAX
+
+/* One pass of the bridge main loop */
+#define SIM_LOOP_TICKS 1u
+
+/* Launcher I2C master at 400 kHz: address or data byte with ACK */
+#define SIM_I2C_BYTE_NS 22500u
+
+/* Connection defaults of the simulated phone */
+#define SIM_INTERVAL_MS 30u
+#define SIM_STACK_BUFFERS 6u  /* notifications the stack takes before it reports busy */
+#define SIM_PACKETS_PER_EVENT 4u
+#define SIM_ADV_FAST_TIMEOUT_S 30u
+#define SIM_ADV_SLOW_TIMEOUT_S 150u
+#define SIM_PAIRING_EVENTS 6u    /* security request to encrypted with new keys, Just Works */
+#define SIM_ENCRYPTION_EVENTS 2u /* security request to encrypted with stored keys */
+
+typedef enum
+{
+	SimLedDiscon,
+	SimLedConnect,
+	SimLedAdv,
+	SimLedCount
+} SIM_LED_T;
+
+typedef struct
+{
+	uint32 advStarts;	  /* advertisements started */
+	uint32 advUpdates;	  /* advertising data updates */
+	uint32 notifications; /* notifications taken by the stack */
+	uint32 refused;		  /* notifications refused for lack of buffers */
+	uint32 linkUpdates;	  /* connection parameter requests */
+	uint32 i2cOverruns;	  /* master writes before the bridge handled the previous one */
+	uint32 i2cWritesPerPass; /* most master writes completed in one main loop pass */
+	uint64_t disconnectTime;
+	uint64_t advRestartTicks; /* disconnect to the next advertisement */
+	uint8 dataReady;		  /* level of the DATA_READY line */
+	uint8 cccd;				  /* TX CCCD as written by the bridge */
+	uint8 leds[SimLedCount];  /* 1 while the LED is lit */
+} SIM_STATS_T;
+
+extern uint64_t simNow;
+extern SIM_STATS_T simStats;
+extern int simVerbose;
+
+/* Phone side, implemented by hal.c */
+extern int simConnect(uint32 intervalMs);
+extern int simDisconnect(void);
+extern void simMtu(uint16 mtu);
+extern void simWrite(uint16 handle, const uint8 *data, uint16 len, uint8 withResponse);
+extern void simStackBuffers(uint8 buffers, uint8 perEvent);
+extern void simLinkUpdates(uint8 accept);
+extern uint8 simLinkQueued(void);
+
+/* Launcher side, implemented by hal.c */
+extern int simI2CReady(void);
+extern void simI2CWrite(const uint8 *data, uint32 len);
+extern void simI2CRead(uint8 *data, uint32 len);
+extern void simI2CWriteRead(const uint8 *wrData, uint32 wrLen, uint8 *rdData, uint32 rdLen);
+
+/* Main loop held up, implemented by hal.c */
+extern void simAdvance(uint64_t ticks);
+
+/* The bridge main(), renamed by the build */
+extern int bridgeMain();
+
+/* Test bench, implemented by bench.c */
+extern uint64_t benchNextDue(void);
+extern void benchRun(void);
+extern void benchBus(void);
+extern void benchNotified(const uint8 *value, uint16 len);
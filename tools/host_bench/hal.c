@@ -0,0 +1,910 @@
+/* ========================================
+ *
+ * Simulated hardware for the host build of the bridge: the BLE stack with
+ * one phone connection, the SCB I2C slave, the WDT time base, the pins and
+ * the power modes. Time only moves forward in CyBle_ProcessEvents() (one
+ * main loop pass), in CyDelay(), in a stall of the main loop and in the
+ * sleep calls, which jump to the next thing that happens. Stack events are
+ * handed to the bridge callback from CyBle_ProcessEvents(), like the real
+ * stack does. The launcher drives the I2C bus on its own clock: transfers
+ * complete whenever time moves, also in the middle of a main loop pass,
+ * and the I2C interrupt runs unless the bridge has it disabled. The phone
+ * pairs on its first connection and keeps the bond, later connections are
+ * encrypted with the stored keys and the CCCD comes back from flash.
+ *
+ * ========================================
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "bench.h"
+
+#define SIM_EVENT_DEPTH 32u
+
+typedef struct
+{
+	uint32 event;
+	union
+	{
+		uint8 busy;
+		uint8 encrypted;
+		uint16 result;
+		CYBLE_GAP_CONN_PARAM_UPDATED_IN_CONTROLLER_T conn;
+		CYBLE_GATT_XCHG_MTU_PARAM_T mtu;
+		CYBLE_GATTS_WRITE_REQ_PARAM_T write;
+	} param;
+	uint8 data[CYBLE_GATT_MTU];
+} SIM_EVENT_T;
+
+typedef struct
+{
+	uint16 len;
+	uint8 data[CYBLE_GATT_MTU];
+} SIM_PACKET_T;
+
+uint64_t simNow;
+SIM_STATS_T simStats;
+int simVerbose;
+
+CYBLE_STATE_T cyBle_state = CYBLE_STATE_STOPPED;
+CYBLE_CONN_HANDLE_T cyBle_connHandle;
+CYBLE_GAP_AUTH_INFO_T cyBle_authInfo;
+uint8 cyBle_pendingFlashWrite;
+uint8 simSFlash[CY_SFLASH_NUMBER_USERROWS * CY_SFLASH_SIZEOF_USERROW];
+
+static CYBLE_GAPP_ADV_PARAMS_T advParams = {0x20u, 0x30u, 0u, 0u, 0u, {0u}, 0x07u, CYBLE_GAPP_SCAN_ANY_CONN_ANY};
+static CYBLE_GAPP_DISC_DATA_T advData = {{0x02u, 0x01u, 0x06u, 0x05u, 0x09u, 'E', 'Z', 'B', 'L'}, 9u};
+static CYBLE_GAPP_SCAN_RSP_DATA_T scanRspData = {{0u}, 0u};
+CYBLE_GAPP_DISC_MODE_INFO_T cyBle_discoveryModeInfo = {0x02u, &advParams, &advData, &scanRspData, 0u};
+
+static CYBLE_CALLBACK_T stackCallback;
+static SIM_EVENT_T events[SIM_EVENT_DEPTH];
+static uint8 eventHead;
+static uint8 eventCount;
+
+static uint64_t advTimeout = SIM_NEVER;
+static uint64_t advNext = SIM_NEVER; /* next advertising event, wakes the bridge */
+static uint8 restartPending;		 /* disconnected, advertising not restarted yet */
+
+/* Bond in the bridge flash, the phone keeps the same */
+static struct
+{
+	uint8 keys; /* paired once */
+	uint8 cccd; /* TX CCCD stored with the bond */
+} bond;
+
+/* Phone connection */
+static struct
+{
+	uint16 interval; /* 1.25 ms units */
+	uint64_t nextEvent;
+	uint16 mtu;
+	uint8 buffers;
+	uint8 perEvent;
+	uint8 busy;
+	uint8 acceptUpdates;
+	uint16 updateInterval;
+	uint64_t updateDue;
+	uint64_t encryptDue; /* pairing or encryption done */
+	uint8 pairing;		 /* the phone pairs instead of using stored keys */
+	SIM_PACKET_T queue[CYBLE_GAP_MAX_BONDED_DEVICE * 8u];
+	uint8 head;
+	uint8 count;
+} link = {.buffers = SIM_STACK_BUFFERS, .perEvent = SIM_PACKETS_PER_EVENT, .acceptUpdates = 1u, .updateDue = SIM_NEVER, .encryptDue = SIM_NEVER};
+
+#define LINK_QUEUE_SIZE (sizeof(link.queue) / sizeof(link.queue[0]))
+
+/* SCB I2C slave */
+static struct
+{
+	uint8 started;
+	uint8 intEnabled;
+	uint8 pending; /* interrupt raised while disabled */
+	uint32 status;
+	uint8 *wrBuf;
+	uint32 wrSize;
+	uint32 wrIndex;
+	uint8 *rdBuf;
+	uint32 rdSize;
+	uint32 rdIndex;
+} i2c;
+
+static uint8 critical;	  /* in a critical section */
+static uint32 passWrites; /* I2C writes completed in this main loop pass */
+
+static uint64_t intervalTicks(uint16 interval)
+{
+	return ((uint64_t)interval * 5u * SIM_HZ) / 4000u;
+}
+
+static uint64_t advIntervalTicks(void)
+{
+	/* 0.625 ms units */
+	return ((uint64_t)cyBle_discoveryModeInfo.advParam->advIntvMin * 5u * SIM_HZ) / 8000u + 1u;
+}
+
+static void postEvent(uint32 event, const void *param, uint32 size)
+{
+	SIM_EVENT_T *slot;
+
+	if (eventCount >= SIM_EVENT_DEPTH)
+	{
+		fprintf(stderr, "sim: stack event queue full, event %u lost\n", (unsigned)event);
+		return;
+	}
+
+	slot = &events[(eventHead + eventCount) % SIM_EVENT_DEPTH];
+	slot->event = event;
+	if (NULL != param)
+	{
+		memcpy(&slot->param, param, size);
+	}
+	eventCount++;
+}
+
+static void postWrite(uint32 event, uint16 handle, const uint8 *data, uint16 len)
+{
+	SIM_EVENT_T *slot;
+
+	if (len > CYBLE_GATT_MTU)
+	{
+		len = CYBLE_GATT_MTU;
+	}
+	postEvent(event, NULL, 0u);
+	slot = &events[(eventHead + eventCount - 1u) % SIM_EVENT_DEPTH];
+	memcpy(slot->data, data, len);
+	slot->param.write.handleValPair.attrHandle = handle;
+	slot->param.write.handleValPair.value.len = len;
+	slot->param.write.connHandle = cyBle_connHandle;
+}
+
+static void deliverEvents(void)
+{
+	SIM_EVENT_T event;
+
+	while (0u != eventCount)
+	{
+		event = events[eventHead];
+		eventHead = (eventHead + 1u) % SIM_EVENT_DEPTH;
+		eventCount--;
+
+		if ((CYBLE_EVT_GATTS_WRITE_REQ == event.event) || (CYBLE_EVT_GATTS_WRITE_CMD_REQ == event.event))
+		{
+			event.param.write.handleValPair.value.val = event.data;
+		}
+		if (NULL != stackCallback)
+		{
+			stackCallback(event.event, &event.param);
+		}
+	}
+}
+
+/* Sends the queued notifications the connection event has room for */
+static void connectionEvent(void)
+{
+	uint8 sent;
+
+	for (sent = 0u; (sent < link.perEvent) && (0u != link.count); sent++)
+	{
+		SIM_PACKET_T *packet = &link.queue[link.head];
+
+		link.head = (link.head + 1u) % LINK_QUEUE_SIZE;
+		link.count--;
+		benchNotified(packet->data, packet->len);
+	}
+
+	if ((0u != link.busy) && (link.count < link.buffers))
+	{
+		uint8 busy = CYBLE_STACK_STATE_FREE;
+
+		link.busy = 0u;
+		postEvent(CYBLE_EVT_STACK_BUSY_STATUS, &busy, sizeof(busy));
+	}
+}
+
+static uint64_t simNextDue(void)
+{
+	uint64_t due = benchNextDue();
+
+	if (0u != eventCount)
+	{
+		return simNow;
+	}
+	if ((CYBLE_STATE_CONNECTED == cyBle_state) && (link.nextEvent < due))
+	{
+		due = link.nextEvent;
+	}
+	if (link.updateDue < due)
+	{
+		due = link.updateDue;
+	}
+	if (link.encryptDue < due)
+	{
+		due = link.encryptDue;
+	}
+	if ((CYBLE_STATE_ADVERTISING == cyBle_state) && (advTimeout < due))
+	{
+		due = advTimeout;
+	}
+	if ((CYBLE_STATE_ADVERTISING == cyBle_state) && (advNext < due))
+	{
+		due = advNext;
+	}
+	return due;
+}
+
+static void simRun(void)
+{
+	if ((CYBLE_STATE_CONNECTED == cyBle_state) && (simNow >= link.nextEvent))
+	{
+		connectionEvent();
+		link.nextEvent += intervalTicks(link.interval);
+	}
+
+	if ((CYBLE_STATE_CONNECTED == cyBle_state) && (simNow >= link.updateDue))
+	{
+		CYBLE_GAP_CONN_PARAM_UPDATED_IN_CONTROLLER_T conn = {0u, link.updateInterval, 0u, 500u};
+
+		link.interval = link.updateInterval;
+		link.updateDue = SIM_NEVER;
+		postEvent(CYBLE_EVT_GAP_CONNECTION_UPDATE_COMPLETE, &conn, sizeof(conn));
+	}
+
+	if ((CYBLE_STATE_CONNECTED == cyBle_state) && (simNow >= link.encryptDue))
+	{
+		uint8 encrypted = 1u;
+
+		if (0u != link.pairing)
+		{
+			/* The component stores the new keys on CyBle_StoreBondingData() */
+			bond.keys = 1u;
+			cyBle_pendingFlashWrite = 1u;
+		}
+		else
+		{
+			simStats.cccd = bond.cccd;
+		}
+		link.encryptDue = SIM_NEVER;
+		postEvent(CYBLE_EVT_GAP_ENCRYPT_CHANGE, &encrypted, sizeof(encrypted));
+	}
+
+	if ((CYBLE_STATE_ADVERTISING == cyBle_state) && (simNow >= advNext))
+	{
+		advNext = simNow + advIntervalTicks();
+	}
+
+	if ((CYBLE_STATE_ADVERTISING == cyBle_state) && (simNow >= advTimeout))
+	{
+		cyBle_state = CYBLE_STATE_DISCONNECTED;
+		advTimeout = SIM_NEVER;
+		postEvent(CYBLE_EVT_GAPP_ADVERTISEMENT_START_STOP, NULL, 0u);
+	}
+
+	benchRun();
+	deliverEvents();
+}
+
+static void simSleep(void)
+{
+	uint64_t due = simNextDue();
+
+	if (SIM_NEVER == due)
+	{
+		fprintf(stderr, "sim: nothing left to wake the bridge\n");
+		exit(2);
+	}
+	if (due > simNow)
+	{
+		simNow = due;
+	}
+}
+
+/* Phone side */
+int simConnect(uint32 intervalMs)
+{
+	CYBLE_GAP_CONN_PARAM_UPDATED_IN_CONTROLLER_T conn = {0u, 0u, 0u, 500u};
+
+	if (CYBLE_STATE_ADVERTISING != cyBle_state)
+	{
+		return 0;
+	}
+
+	cyBle_state = CYBLE_STATE_CONNECTED;
+	cyBle_connHandle.bdHandle = 0u;
+	cyBle_connHandle.attId = 0u;
+	advTimeout = SIM_NEVER;
+
+	link.interval = (uint16)((intervalMs * 4u) / 5u);
+	link.nextEvent = simNow + intervalTicks(link.interval);
+	link.mtu = CYBLE_GATT_DEFAULT_MTU;
+	link.busy = 0u;
+	link.count = 0u;
+	link.updateDue = SIM_NEVER;
+	link.encryptDue = SIM_NEVER;
+	simStats.cccd = 0u;
+
+	conn.connIntv = link.interval;
+	postEvent(CYBLE_EVT_GAPP_ADVERTISEMENT_START_STOP, NULL, 0u);
+	postEvent(CYBLE_EVT_GAP_DEVICE_CONNECTED, &conn, sizeof(conn));
+	postEvent(CYBLE_EVT_GATT_CONNECT_IND, &cyBle_connHandle, sizeof(cyBle_connHandle));
+	return 1;
+}
+
+int simDisconnect(void)
+{
+	if (CYBLE_STATE_CONNECTED != cyBle_state)
+	{
+		return 0;
+	}
+
+	cyBle_state = CYBLE_STATE_DISCONNECTED;
+	link.count = 0u;
+	link.busy = 0u;
+	link.updateDue = SIM_NEVER;
+	link.encryptDue = SIM_NEVER;
+	simStats.disconnectTime = simNow;
+	restartPending = 1u;
+
+	postEvent(CYBLE_EVT_GATT_DISCONNECT_IND, &cyBle_connHandle, sizeof(cyBle_connHandle));
+	postEvent(CYBLE_EVT_GAP_DEVICE_DISCONNECTED, NULL, 0u);
+	return 1;
+}
+
+void simMtu(uint16 mtu)
+{
+	CYBLE_GATT_XCHG_MTU_PARAM_T param;
+
+	/* The component answers with CYBLE_GATT_MTU, the smaller one is used */
+	link.mtu = (mtu < CYBLE_GATT_MTU) ? mtu : CYBLE_GATT_MTU;
+	param.connHandle = cyBle_connHandle;
+	param.mtu = mtu;
+	postEvent(CYBLE_EVT_GATTS_XCNHG_MTU_REQ, &param, sizeof(param));
+}
+
+void simWrite(uint16 handle, const uint8 *data, uint16 len, uint8 withResponse)
+{
+	postWrite(withResponse ? CYBLE_EVT_GATTS_WRITE_REQ : CYBLE_EVT_GATTS_WRITE_CMD_REQ, handle, data, len);
+}
+
+void simStackBuffers(uint8 buffers, uint8 perEvent)
+{
+	if (buffers > LINK_QUEUE_SIZE)
+	{
+		buffers = LINK_QUEUE_SIZE;
+	}
+	link.buffers = (0u != buffers) ? buffers : 1u;
+	link.perEvent = (0u != perEvent) ? perEvent : 1u;
+}
+
+void simLinkUpdates(uint8 accept)
+{
+	link.acceptUpdates = accept;
+}
+
+uint8 simLinkQueued(void)
+{
+	return link.count;
+}
+
+/* Launcher side */
+/* The slave stretches the clock of the next transfer until the interrupt
+   of the last one has run */
+int simI2CReady(void)
+{
+	return (0u != i2c.started) && (0u == i2c.pending);
+}
+
+static void i2cService(void)
+{
+	if ((0u == i2c.pending) || (0u == i2c.intEnabled) || (0u != critical))
+	{
+		return;
+	}
+	i2c.pending = 0u;
+#ifdef I2C_I2C_ISR_EXIT_CALLBACK
+	I2C_I2C_ISR_ExitCallback();
+#endif
+}
+
+static void i2cInterrupt(void)
+{
+	i2c.pending = 1u;
+	i2cService();
+}
+
+/* Moves time forward while the bridge code does not return, the launcher
+   keeps driving the bus */
+void simAdvance(uint64_t ticks)
+{
+	uint64_t end = simNow + ticks;
+
+	while (simNow < end)
+	{
+		simNow++;
+		benchBus();
+	}
+}
+
+static void i2cSlaveWrite(const uint8 *data, uint32 len)
+{
+	uint32 i;
+
+	/* The SCB keeps writing behind the bytes of an unhandled write */
+	if (0u != (i2c.status & I2C_I2C_SSTAT_WR_CMPLT))
+	{
+		simStats.i2cOverruns++;
+	}
+
+	/* Address match */
+	i2c.status |= I2C_I2C_SSTAT_WR_BUSY;
+	i2cInterrupt();
+
+	for (i = 0u; i < len; i++)
+	{
+		if (i2c.wrIndex < i2c.wrSize)
+		{
+			i2c.wrBuf[i2c.wrIndex++] = data[i];
+		}
+		else
+		{
+			i2c.status |= I2C_I2C_SSTAT_WR_OVFL;
+		}
+	}
+	i2c.status = (i2c.status & ~I2C_I2C_SSTAT_WR_BUSY) | I2C_I2C_SSTAT_WR_CMPLT;
+	passWrites++;
+	if (passWrites > simStats.i2cWritesPerPass)
+	{
+		simStats.i2cWritesPerPass = passWrites;
+	}
+	i2cInterrupt();
+}
+
+static void i2cSlaveRead(uint8 *data, uint32 len)
+{
+	uint32 i;
+
+	/* Address match */
+	i2c.status |= I2C_I2C_SSTAT_RD_BUSY;
+	i2cInterrupt();
+
+	for (i = 0u; i < len; i++)
+	{
+		if (i2c.rdIndex < i2c.rdSize)
+		{
+			data[i] = i2c.rdBuf[i2c.rdIndex++];
+		}
+		else
+		{
+			data[i] = 0xFFu;
+			i2c.status |= I2C_I2C_SSTAT_RD_OVFL;
+		}
+	}
+	i2c.status = (i2c.status & ~I2C_I2C_SSTAT_RD_BUSY) | I2C_I2C_SSTAT_RD_CMPLT;
+	i2cInterrupt();
+}
+
+void simI2CWrite(const uint8 *data, uint32 len)
+{
+	i2cSlaveWrite(data, len);
+}
+
+void simI2CRead(uint8 *data, uint32 len)
+{
+	i2cSlaveRead(data, len);
+}
+
+void simI2CWriteRead(const uint8 *wrData, uint32 wrLen, uint8 *rdData, uint32 rdLen)
+{
+	/* The repeated start completes the write first */
+	i2cSlaveWrite(wrData, wrLen);
+	i2cSlaveRead(rdData, rdLen);
+}
+
+/* cy_boot */
+void CyDelay(uint32 milliseconds)
+{
+	simAdvance(SIM_MS(milliseconds));
+}
+
+uint8 CyEnterCriticalSection(void)
+{
+	uint8 saved = critical;
+
+	critical = 1u;
+	return saved;
+}
+
+void CyExitCriticalSection(uint8 savedIntrStatus)
+{
+	critical = savedIntrStatus;
+	i2cService();
+}
+
+void CySysClkWriteHfclkDirect(uint32 clkSelect)
+{
+	(void)clkSelect;
+}
+
+void CySysClkImoStop(void)
+{
+}
+
+void CySysClkImoStart(void)
+{
+}
+
+void CySysPmSleep(void)
+{
+	simSleep();
+}
+
+void CySysPmDeepSleep(void)
+{
+	simSleep();
+}
+
+void CySysWdtUnlock(void)
+{
+}
+
+void CySysWdtLock(void)
+{
+}
+
+void CySysWdtWriteMode(uint32 counterNum, uint32 mode)
+{
+	(void)counterNum;
+	(void)mode;
+}
+
+void CySysWdtEnable(uint32 counterMask)
+{
+	(void)counterMask;
+}
+
+uint32 CySysWdtReadCount(uint32 counterNum)
+{
+	(void)counterNum;
+	return (uint32)simNow;
+}
+
+/* BLE stack */
+CYBLE_API_RESULT_T CyBle_Start(CYBLE_CALLBACK_T callbackFunc)
+{
+	stackCallback = callbackFunc;
+	cyBle_state = CYBLE_STATE_DISCONNECTED;
+	postEvent(CYBLE_EVT_STACK_ON, NULL, 0u);
+	return CYBLE_ERROR_OK;
+}
+
+void CyBle_ProcessEvents(void)
+{
+	passWrites = 0u;
+	simNow += SIM_LOOP_TICKS;
+	simRun();
+}
+
+CYBLE_STATE_T CyBle_GetState(void)
+{
+	return cyBle_state;
+}
+
+CYBLE_LP_MODE_T CyBle_EnterLPM(CYBLE_LP_MODE_T pwrMode)
+{
+	return pwrMode;
+}
+
+CYBLE_BLESS_STATE_T CyBle_GetBleSsState(void)
+{
+	return CYBLE_BLESS_STATE_ECO_ON;
+}
+
+CYBLE_API_RESULT_T CyBle_GappStartAdvertisement(uint8 advertisingIntervalType)
+{
+	uint32 timeout;
+
+	if (CYBLE_STATE_DISCONNECTED != cyBle_state)
+	{
+		return CYBLE_ERROR_INVALID_STATE;
+	}
+
+	switch (advertisingIntervalType)
+	{
+	case CYBLE_ADVERTISING_FAST:
+		timeout = SIM_ADV_FAST_TIMEOUT_S;
+		break;
+	case CYBLE_ADVERTISING_SLOW:
+		timeout = SIM_ADV_SLOW_TIMEOUT_S;
+		break;
+	default:
+		timeout = cyBle_discoveryModeInfo.advTo;
+		break;
+	}
+	advTimeout = (0u != timeout) ? (simNow + SIM_MS(timeout * 1000u)) : SIM_NEVER;
+
+	cyBle_state = CYBLE_STATE_ADVERTISING;
+	advNext = simNow + advIntervalTicks();
+	simStats.advStarts++;
+	if (0u != restartPending)
+	{
+		restartPending = 0u;
+		simStats.advRestartTicks = simNow - simStats.disconnectTime;
+	}
+	postEvent(CYBLE_EVT_GAPP_ADVERTISEMENT_START_STOP, NULL, 0u);
+	return CYBLE_ERROR_OK;
+}
+
+void CyBle_GappStopAdvertisement(void)
+{
+	if (CYBLE_STATE_ADVERTISING == cyBle_state)
+	{
+		cyBle_state = CYBLE_STATE_DISCONNECTED;
+		advTimeout = SIM_NEVER;
+		postEvent(CYBLE_EVT_GAPP_ADVERTISEMENT_START_STOP, NULL, 0u);
+	}
+}
+
+CYBLE_API_RESULT_T CyBle_GapUpdateAdvData(CYBLE_GAPP_DISC_DATA_T *advDiscData, CYBLE_GAPP_SCAN_RSP_DATA_T *advScanRespData)
+{
+	(void)advDiscData;
+	(void)advScanRespData;
+	simStats.advUpdates++;
+	return CYBLE_ERROR_OK;
+}
+
+CYBLE_API_RESULT_T CyBle_GapAuthReq(uint8 bdHandle, CYBLE_GAP_AUTH_INFO_T *authInfo)
+{
+	(void)bdHandle;
+	(void)authInfo;
+	if (CYBLE_STATE_CONNECTED != cyBle_state)
+	{
+		return CYBLE_ERROR_INVALID_STATE;
+	}
+
+	/* Answer to the security request: a bonded phone starts encryption, the
+	   others pair first */
+	link.pairing = (0u == bond.keys);
+	if (0u != link.pairing)
+	{
+		postEvent(CYBLE_EVT_GAP_AUTH_REQ, NULL, 0u);
+		link.encryptDue = simNow + SIM_PAIRING_EVENTS * intervalTicks(link.interval);
+	}
+	else
+	{
+		link.encryptDue = simNow + SIM_ENCRYPTION_EVENTS * intervalTicks(link.interval);
+	}
+	return CYBLE_ERROR_OK;
+}
+
+CYBLE_API_RESULT_T CyBle_StoreBondingData(uint8 isForceWrite)
+{
+	(void)isForceWrite;
+	if (0u != cyBle_pendingFlashWrite)
+	{
+		bond.cccd = simStats.cccd;
+	}
+	cyBle_pendingFlashWrite = 0u;
+	return CYBLE_ERROR_OK;
+}
+
+CYBLE_API_RESULT_T CyBle_L2capLeConnectionParamUpdateRequest(uint8 bdHandle, CYBLE_GAP_CONN_UPDATE_PARAM_T *connParam)
+{
+	uint16 result = (0u != link.acceptUpdates) ? 0u : 1u;
+
+	(void)bdHandle;
+	if (CYBLE_STATE_CONNECTED != cyBle_state)
+	{
+		return CYBLE_ERROR_INVALID_STATE;
+	}
+
+	simStats.linkUpdates++;
+	postEvent(CYBLE_EVT_L2CAP_CONN_PARAM_UPDATE_RSP, &result, sizeof(result));
+	if (0u == result)
+	{
+		/* The phone picks the fastest interval allowed, a few events later */
+		link.updateInterval = connParam->connIntvMin;
+		link.updateDue = simNow + 6u * intervalTicks(link.interval);
+	}
+	return CYBLE_ERROR_OK;
+}
+
+CYBLE_API_RESULT_T CyBle_GattsNotification(CYBLE_CONN_HANDLE_T connHandle, CYBLE_GATTS_HANDLE_VALUE_NTF_T *ntfParam)
+{
+	SIM_PACKET_T *packet;
+
+	(void)connHandle;
+	if (CYBLE_STATE_CONNECTED != cyBle_state)
+	{
+		return CYBLE_ERROR_INVALID_STATE;
+	}
+	if (0u == simStats.cccd)
+	{
+		return CYBLE_ERROR_NTF_DISABLED;
+	}
+	if (ntfParam->value.len > (link.mtu - 3u))
+	{
+		return CYBLE_ERROR_INVALID_PARAMETER;
+	}
+	if (link.count >= link.buffers)
+	{
+		simStats.refused++;
+		return CYBLE_ERROR_MEMORY_ALLOCATION_FAILED;
+	}
+
+	packet = &link.queue[(link.head + link.count) % LINK_QUEUE_SIZE];
+	packet->len = ntfParam->value.len;
+	memcpy(packet->data, ntfParam->value.val, packet->len);
+	link.count++;
+	simStats.notifications++;
+
+	if (link.count >= link.buffers)
+	{
+		uint8 busy = CYBLE_STACK_STATE_BUSY;
+
+		link.busy = 1u;
+		postEvent(CYBLE_EVT_STACK_BUSY_STATUS, &busy, sizeof(busy));
+	}
+	return CYBLE_ERROR_OK;
+}
+
+CYBLE_GATT_ERR_CODE_T CyBle_GattsWriteAttributeValue(CYBLE_GATT_HANDLE_VALUE_PAIR_T *handleValuePair, uint16 offset, CYBLE_CONN_HANDLE_T *connHandle, uint8 flags)
+{
+	(void)offset;
+	(void)connHandle;
+	(void)flags;
+	if (CYBLE_VOICE_ASSISTANT_LAUNCHER_TXCHARACTERISTIC_CLIENT_CHARACTERISTIC_CONFIGURATION_DESC_HANDLE == handleValuePair->attrHandle)
+	{
+		simStats.cccd = handleValuePair->value.val[0] & CYBLE_CCCD_NOTIFICATION;
+		if (0u != bond.keys)
+		{
+			/* The CCCD of a bonded phone goes to flash */
+			cyBle_pendingFlashWrite = 1u;
+		}
+	}
+	return CYBLE_GATT_ERR_NONE;
+}
+
+CYBLE_GATT_ERR_CODE_T CyBle_GattsReadAttributeValue(CYBLE_GATT_HANDLE_VALUE_PAIR_T *handleValuePair, CYBLE_CONN_HANDLE_T *connHandle, uint8 flags)
+{
+	(void)connHandle;
+	(void)flags;
+	memset(handleValuePair->value.val, 0, handleValuePair->value.len);
+	if (CYBLE_VOICE_ASSISTANT_LAUNCHER_TXCHARACTERISTIC_CLIENT_CHARACTERISTIC_CONFIGURATION_DESC_HANDLE == handleValuePair->attrHandle)
+	{
+		handleValuePair->value.val[0] = simStats.cccd;
+	}
+	return CYBLE_GATT_ERR_NONE;
+}
+
+CYBLE_API_RESULT_T CyBle_GattsWriteRsp(CYBLE_CONN_HANDLE_T connHandle)
+{
+	(void)connHandle;
+	return CYBLE_ERROR_OK;
+}
+
+void CyBle_GattsPrepWriteReqSupport(uint8 prepWriteSupport)
+{
+	(void)prepWriteSupport;
+}
+
+/* I2C slave */
+void I2C_Start(void)
+{
+	i2c.started = 1u;
+	i2c.intEnabled = 1u;
+}
+
+void I2C_Stop(void)
+{
+	i2c.started = 0u;
+}
+
+void I2C_Sleep(void)
+{
+}
+
+void I2C_Wakeup(void)
+{
+}
+
+void I2C_EnableInt(void)
+{
+	i2c.intEnabled = 1u;
+	i2cService();
+}
+
+void I2C_DisableInt(void)
+{
+	i2c.intEnabled = 0u;
+}
+
+uint32 I2C_I2CSlaveStatus(void)
+{
+	return i2c.status;
+}
+
+uint32 I2C_I2CSlaveClearReadStatus(void)
+{
+	uint32 status = i2c.status & I2C_I2C_SSTAT_RD_MASK;
+
+	i2c.status &= ~I2C_I2C_SSTAT_RD_MASK;
+	return status;
+}
+
+uint32 I2C_I2CSlaveClearWriteStatus(void)
+{
+	uint32 status = i2c.status & I2C_I2C_SSTAT_WR_MASK;
+
+	i2c.status &= ~I2C_I2C_SSTAT_WR_MASK;
+	return status;
+}
+
+void I2C_I2CSlaveInitReadBuf(uint8 *rdBuf, uint32 bufSize)
+{
+	i2c.rdBuf = rdBuf;
+	i2c.rdSize = bufSize;
+	i2c.rdIndex = 0u;
+}
+
+void I2C_I2CSlaveInitWriteBuf(uint8 *wrBuf, uint32 bufSize)
+{
+	i2c.wrBuf = wrBuf;
+	i2c.wrSize = bufSize;
+	i2c.wrIndex = 0u;
+}
+
+uint32 I2C_I2CSlaveGetReadBufSize(void)
+{
+	return i2c.rdIndex;
+}
+
+uint32 I2C_I2CSlaveGetWriteBufSize(void)
+{
+	return i2c.wrIndex;
+}
+
+void I2C_I2CSlaveClearReadBuf(void)
+{
+	i2c.rdIndex = 0u;
+}
+
+void I2C_I2CSlaveClearWriteBuf(void)
+{
+	i2c.wrIndex = 0u;
+}
+
+/* Pins, the LEDs are active low and switched off around every deep sleep */
+void DISCON_LED_Write(uint8 value)
+{
+	simStats.leds[SimLedDiscon] = (uint8)(0u == value);
+}
+
+void CONNECT_LED_Write(uint8 value)
+{
+	simStats.leds[SimLedConnect] = (uint8)(0u == value);
+}
+
+void ADV_LED_Write(uint8 value)
+{
+	simStats.leds[SimLedAdv] = (uint8)(0u == value);
+}
+
+void DISCON_LED_SetDriveMode(uint8 mode)
+{
+	(void)mode;
+}
+
+void CONNECT_LED_SetDriveMode(uint8 mode)
+{
+	(void)mode;
+}
+
+void ADV_LED_SetDriveMode(uint8 mode)
+{
+	(void)mode;
+}
+
+void DATA_READY_Write(uint8 value)
+{
+	simStats.dataReady = value;
+}
@@ -0,0 +1,386 @@
+/* ========================================
+ *
+ * Host stand-in for the project.h PSoC Creator generates for
+ * EZ-BLE_PRoC_Module: the types, constants and functions of the BLE, I2C
+ * (SCB), pin, WDT and power APIs the bridge uses. The functions are
+ * implemented by hal.c on top of a simulated clock.
+ *
+ * Only what the bridge sources need is declared, with the names and
+ * signatures of the PSoC 4 BLE component 3.x and cy_boot.
+ *
+ * ========================================
+*/
+#pragma once
+#include <stdint.h>
+#include <string.h>
+
+typedef uint8_t uint8;
+typedef uint16_t uint16;
+typedef uint32_t uint32;
+typedef uint64_t uint64;
+typedef int8_t int8;
+typedef int16_t int16;
+typedef int32_t int32;
+
+#define CYPACKED
+#define CYPACKED_ATTR __attribute__((packed))
+#define LO8(x) ((uint8)((x) & 0xFFu))
+#define HI8(x) ((uint8)(((x) >> 8) & 0xFFu))
+
+/* cy_boot */
+#define CyGlobalIntEnable
+void CyDelay(uint32 milliseconds);
+uint8 CyEnterCriticalSection(void);
+void CyExitCriticalSection(uint8 savedIntrStatus);
+
+#define CY_SYS_CLK_HFCLK_IMO 0u
+#define CY_SYS_CLK_HFCLK_ECO 1u
+void CySysClkWriteHfclkDirect(uint32 clkSelect);
+void CySysClkImoStop(void);
+void CySysClkImoStart(void);
+void CySysPmSleep(void);
+void CySysPmDeepSleep(void);
+
+#define CY_SYS_WDT_COUNTER0 0u
+#define CY_SYS_WDT_COUNTER1 1u
+#define CY_SYS_WDT_COUNTER2 2u
+#define CY_SYS_WDT_COUNTER0_MASK 0x1u
+#define CY_SYS_WDT_COUNTER1_MASK 0x100u
+#define CY_SYS_WDT_COUNTER2_MASK 0x10000u
+#define CY_SYS_WDT_MODE_NONE 0u
+#define CY_SYS_WDT_MODE_INT 1u
+void CySysWdtUnlock(void);
+void CySysWdtLock(void);
+void CySysWdtWriteMode(uint32 counterNum, uint32 mode);
+void CySysWdtEnable(uint32 counterMask);
+uint32 CySysWdtReadCount(uint32 counterNum);
+
+/* User SFlash rows, erased on the bench */
+#define CY_SFLASH_NUMBER_USERROWS 4u
+#define CY_SFLASH_SIZEOF_USERROW 128u
+extern uint8 simSFlash[CY_SFLASH_NUMBER_USERROWS * CY_SFLASH_SIZEOF_USERROW];
+#define CY_SFLASH_USERBASE ((uintptr_t)simSFlash)
+
+/* BLE component: stack */
+typedef enum
+{
+	CYBLE_ERROR_OK = 0,
+	CYBLE_ERROR_INVALID_PARAMETER,
+	CYBLE_ERROR_INVALID_OPERATION,
+	CYBLE_ERROR_MEMORY_ALLOCATION_FAILED,
+	CYBLE_ERROR_INSUFFICIENT_RESOURCES,
+	CYBLE_ERROR_NO_DEVICE_ENTITY,
+	CYBLE_ERROR_NTF_DISABLED,
+	CYBLE_ERROR_IND_DISABLED,
+	CYBLE_ERROR_INVALID_STATE,
+	CYBLE_ERROR_MAX = 0xFF
+} CYBLE_API_RESULT_T;
+
+typedef enum
+{
+	CYBLE_STATE_STOPPED,
+	CYBLE_STATE_INITIALIZING,
+	CYBLE_STATE_CONNECTED,
+	CYBLE_STATE_ADVERTISING,
+	CYBLE_STATE_DISCONNECTED
+} CYBLE_STATE_T;
+
+enum
+{
+	CYBLE_EVT_STACK_ON = 1,
+	CYBLE_EVT_TIMEOUT,
+	CYBLE_EVT_HARDWARE_ERROR,
+	CYBLE_EVT_STACK_BUSY_STATUS,
+	CYBLE_EVT_PENDING_FLASH_WRITE,
+	CYBLE_EVT_GAPP_ADVERTISEMENT_START_STOP,
+	CYBLE_EVT_GAP_DEVICE_CONNECTED,
+	CYBLE_EVT_GAP_DEVICE_DISCONNECTED,
+	CYBLE_EVT_GAP_CONNECTION_UPDATE_COMPLETE,
+	CYBLE_EVT_GAP_AUTH_REQ,
+	CYBLE_EVT_GAP_AUTH_COMPLETE,
+	CYBLE_EVT_GAP_AUTH_FAILED,
+	CYBLE_EVT_GAP_ENCRYPT_CHANGE,
+	CYBLE_EVT_GATT_CONNECT_IND,
+	CYBLE_EVT_GATT_DISCONNECT_IND,
+	CYBLE_EVT_GATTS_XCNHG_MTU_REQ,
+	CYBLE_EVT_GATTS_WRITE_REQ,
+	CYBLE_EVT_GATTS_WRITE_CMD_REQ,
+	CYBLE_EVT_GATTS_PREP_WRITE_REQ,
+	CYBLE_EVT_GATTS_EXEC_WRITE_REQ,
+	CYBLE_EVT_GATTS_READ_CHAR_VAL_ACCESS_REQ,
+	CYBLE_EVT_L2CAP_CONN_PARAM_UPDATE_RSP
+};
+
+typedef void (*CYBLE_CALLBACK_T)(uint32 eventCode, void *eventParam);
+
+CYBLE_API_RESULT_T CyBle_Start(CYBLE_CALLBACK_T callbackFunc);
+void CyBle_ProcessEvents(void);
+CYBLE_STATE_T CyBle_GetState(void);
+
+#define CYBLE_STACK_STATE_BUSY 0x01u
+#define CYBLE_STACK_STATE_FREE 0x00u
+
+typedef enum
+{
+	CYBLE_BLESS_ACTIVE = 1,
+	CYBLE_BLESS_SLEEP,
+	CYBLE_BLESS_DEEPSLEEP,
+	CYBLE_BLESS_HIBERNATE,
+	CYBLE_BLESS_INVALID = 0xFF
+} CYBLE_LP_MODE_T;
+
+typedef enum
+{
+	CYBLE_BLESS_STATE_ACTIVE = 1,
+	CYBLE_BLESS_STATE_EVENT_CLOSE,
+	CYBLE_BLESS_STATE_SLEEP,
+	CYBLE_BLESS_STATE_ECO_ON,
+	CYBLE_BLESS_STATE_ECO_STABLE,
+	CYBLE_BLESS_STATE_DEEPSLEEP,
+	CYBLE_BLESS_STATE_HIBERNATE,
+	CYBLE_BLESS_STATE_INVALID = 0xFF
+} CYBLE_BLESS_STATE_T;
+
+CYBLE_LP_MODE_T CyBle_EnterLPM(CYBLE_LP_MODE_T pwrMode);
+CYBLE_BLESS_STATE_T CyBle_GetBleSsState(void);
+
+/* BLE component: GAP */
+#define CYBLE_GAP_BD_ADDR_SIZE 6u
+#define CYBLE_GAP_MAX_BONDED_DEVICE 4u
+#define CYBLE_GAP_MAX_ADV_DATA_LEN 31u
+
+typedef struct
+{
+	uint8 bdHandle;
+	uint8 attId;
+} CYBLE_CONN_HANDLE_T;
+
+typedef struct
+{
+	uint8 status;
+	uint16 connIntv;
+	uint16 connLatency;
+	uint16 supervisionTO;
+} CYBLE_GAP_CONN_PARAM_UPDATED_IN_CONTROLLER_T;
+
+typedef struct
+{
+	uint16 connIntvMin;
+	uint16 connIntvMax;
+	uint16 connLatency;
+	uint16 supervisionTO;
+} CYBLE_GAP_CONN_UPDATE_PARAM_T;
+
+typedef struct
+{
+	uint8 bdAddr[CYBLE_GAP_BD_ADDR_SIZE];
+	uint8 type;
+} CYBLE_GAP_BD_ADDR_T;
+
+typedef struct
+{
+	uint8 count;
+	CYBLE_GAP_BD_ADDR_T bdAddrList[CYBLE_GAP_MAX_BONDED_DEVICE];
+} CYBLE_GAP_BONDED_DEV_ADDR_LIST_T;
+
+typedef struct
+{
+	uint8 security;
+	uint8 bonding;
+	uint8 ekeySize;
+	uint8 authErr;
+	uint8 pairingProperties;
+} CYBLE_GAP_AUTH_INFO_T;
+
+#define CYBLE_ADVERTISING_FAST 0u
+#define CYBLE_ADVERTISING_SLOW 1u
+#define CYBLE_ADVERTISING_CUSTOM 2u
+
+#define CYBLE_GAPP_SCAN_ANY_CONN_ANY 0x00u
+#define CYBLE_GAPP_SCAN_WHITELIST_CONN_ANY 0x01u
+#define CYBLE_GAPP_SCAN_ANY_CONN_WHITELIST 0x02u
+#define CYBLE_GAPP_SCAN_CONN_WHITELIST_ONLY 0x03u
+
+typedef struct
+{
+	uint16 advIntvMin;
+	uint16 advIntvMax;
+	uint8 advType;
+	uint8 ownAddrType;
+	uint8 directAddrType;
+	uint8 directAddr[CYBLE_GAP_BD_ADDR_SIZE];
+	uint8 advChannelMap;
+	uint8 advFilterPolicy;
+} CYBLE_GAPP_ADV_PARAMS_T;
+
+typedef struct
+{
+	uint8 advData[CYBLE_GAP_MAX_ADV_DATA_LEN];
+	uint8 advDataLen;
+} CYBLE_GAPP_DISC_DATA_T;
+
+typedef struct
+{
+	uint8 scanRspData[CYBLE_GAP_MAX_ADV_DATA_LEN];
+	uint8 scanRspDataLen;
+} CYBLE_GAPP_SCAN_RSP_DATA_T;
+
+typedef struct
+{
+	uint8 discMode;
+	CYBLE_GAPP_ADV_PARAMS_T *advParam;
+	CYBLE_GAPP_DISC_DATA_T *advData;
+	CYBLE_GAPP_SCAN_RSP_DATA_T *scanRspData;
+	uint16 advTo;
+} CYBLE_GAPP_DISC_MODE_INFO_T;
+
+/* Bonding as set in the BLE component, the phone keeps the bond of its
+   first connection, see hal.c */
+#define CYBLE_BONDING_YES 1u
+#define CYBLE_BONDING_NO 0u
+#define CYBLE_BONDING_REQUIREMENT CYBLE_BONDING_YES
+
+extern CYBLE_STATE_T cyBle_state;
+extern CYBLE_CONN_HANDLE_T cyBle_connHandle;
+extern CYBLE_GAPP_DISC_MODE_INFO_T cyBle_discoveryModeInfo;
+extern CYBLE_GAP_AUTH_INFO_T cyBle_authInfo;
+extern uint8 cyBle_pendingFlashWrite;
+
+CYBLE_API_RESULT_T CyBle_GappStartAdvertisement(uint8 advertisingIntervalType);
+void CyBle_GappStopAdvertisement(void);
+CYBLE_API_RESULT_T CyBle_GapUpdateAdvData(CYBLE_GAPP_DISC_DATA_T *advDiscData, CYBLE_GAPP_SCAN_RSP_DATA_T *advScanRespData);
+CYBLE_API_RESULT_T CyBle_GapAuthReq(uint8 bdHandle, CYBLE_GAP_AUTH_INFO_T *authInfo);
+CYBLE_API_RESULT_T CyBle_StoreBondingData(uint8 isForceWrite);
+CYBLE_API_RESULT_T CyBle_L2capLeConnectionParamUpdateRequest(uint8 bdHandle, CYBLE_GAP_CONN_UPDATE_PARAM_T *connParam);
+
+/* BLE component: GATT server */
+#define CYBLE_GATT_DEFAULT_MTU 23u
+#define CYBLE_GATT_MTU 67u
+#define CYBLE_CCCD_NOTIFICATION 0x01u
+
+typedef uint16 CYBLE_GATT_DB_ATTR_HANDLE_T;
+
+typedef enum
+{
+	CYBLE_GATT_DB_LOCALLY_INITIATED = 0,
+	CYBLE_GATT_DB_PEER_INITIATED
+} CYBLE_GATT_DB_ATTR_FLAGS_T;
+
+typedef enum
+{
+	CYBLE_GATT_ERR_NONE = 0,
+	CYBLE_GATT_ERR_INVALID_HANDLE
+} CYBLE_GATT_ERR_CODE_T;
+
+typedef struct
+{
+	uint8 *val;
+	uint16 len;
+	uint16 actualLen;
+} CYBLE_GATT_VALUE_T;
+
+typedef struct
+{
+	CYBLE_GATT_VALUE_T value;
+	CYBLE_GATT_DB_ATTR_HANDLE_T attrHandle;
+} CYBLE_GATT_HANDLE_VALUE_PAIR_T;
+
+typedef CYBLE_GATT_HANDLE_VALUE_PAIR_T CYBLE_GATTS_HANDLE_VALUE_NTF_T;
+
+typedef struct
+{
+	CYBLE_GATT_HANDLE_VALUE_PAIR_T handleValPair;
+	CYBLE_CONN_HANDLE_T connHandle;
+} CYBLE_GATTS_WRITE_REQ_PARAM_T;
+
+typedef struct
+{
+	CYBLE_CONN_HANDLE_T connHandle;
+	uint16 mtu;
+} CYBLE_GATT_XCHG_MTU_PARAM_T;
+
+typedef struct
+{
+	CYBLE_GATT_HANDLE_VALUE_PAIR_T handleValuePair;
+	uint16 offset;
+} CYBLE_GATT_HANDLE_VALUE_OFFSET_PARAM_T;
+
+typedef CYBLE_GATT_HANDLE_VALUE_OFFSET_PARAM_T CYBLE_GATTS_PREPARE_WRITE_REQ_T;
+
+typedef struct
+{
+	CYBLE_CONN_HANDLE_T connHandle;
+	CYBLE_GATTS_PREPARE_WRITE_REQ_T *baseAddr;
+	uint16 currentPrepWriteReqCount;
+	uint8 gattErrorCode;
+} CYBLE_GATTS_PREP_WRITE_REQ_PARAM_T;
+
+typedef struct
+{
+	CYBLE_CONN_HANDLE_T connHandle;
+	CYBLE_GATT_HANDLE_VALUE_OFFSET_PARAM_T *baseAddr;
+	uint8 prepWriteReqCount;
+	uint8 execWriteFlag;
+	CYBLE_GATT_DB_ATTR_HANDLE_T attrHandle;
+	uint8 gattErrorCode;
+} CYBLE_GATTS_EXEC_WRITE_REQ_T;
+
+#define CYBLE_GATTS_PREP_WRITE_SUPPORT 0x00u
+#define CYBLE_GATTS_PREP_WRITE_NOT_SUPPORT 0x01u
+#define CYBLE_GATT_EXECUTE_WRITE_CANCEL_FLAG 0x00u
+#define CYBLE_GATT_EXECUTE_WRITE_EXEC_FLAG 0x01u
+
+CYBLE_API_RESULT_T CyBle_GattsNotification(CYBLE_CONN_HANDLE_T connHandle, CYBLE_GATTS_HANDLE_VALUE_NTF_T *ntfParam);
+CYBLE_GATT_ERR_CODE_T CyBle_GattsWriteAttributeValue(CYBLE_GATT_HANDLE_VALUE_PAIR_T *handleValuePair, uint16 offset, CYBLE_CONN_HANDLE_T *connHandle, uint8 flags);
+CYBLE_GATT_ERR_CODE_T CyBle_GattsReadAttributeValue(CYBLE_GATT_HANDLE_VALUE_PAIR_T *handleValuePair, CYBLE_CONN_HANDLE_T *connHandle, uint8 flags);
+CYBLE_API_RESULT_T CyBle_GattsWriteRsp(CYBLE_CONN_HANDLE_T connHandle);
+void CyBle_GattsPrepWriteReqSupport(uint8 prepWriteSupport);
+
+/* Voice Assistant Launcher service, handles as generated for the bridge */
+#define CYBLE_VOICE_ASSISTANT_LAUNCHER_TXCHARACTERISTIC_CHAR_HANDLE 0x000Eu
+#define CYBLE_VOICE_ASSISTANT_LAUNCHER_TXCHARACTERISTIC_CLIENT_CHARACTERISTIC_CONFIGURATION_DESC_HANDLE 0x000Fu
+#define CYBLE_VOICE_ASSISTANT_LAUNCHER_RXCHARACTERISTIC_CHAR_HANDLE 0x0012u
+#define CYBLE_VOICE_ASSISTANT_LAUNCHER_RXSTREAM_CHAR_HANDLE 0x0017u
+
+/* I2C component (SCB in I2C slave mode) */
+#define I2C_I2C_SSTAT_RD_CMPLT 0x01u
+#define I2C_I2C_SSTAT_RD_BUSY 0x02u
+#define I2C_I2C_SSTAT_RD_OVFL 0x04u
+#define I2C_I2C_SSTAT_RD_MASK 0x0Fu
+#define I2C_I2C_SSTAT_WR_CMPLT 0x10u
+#define I2C_I2C_SSTAT_WR_BUSY 0x20u
+#define I2C_I2C_SSTAT_WR_OVFL 0x40u
+#define I2C_I2C_SSTAT_WR_MASK 0xF0u
+
+void I2C_Start(void);
+void I2C_Stop(void);
+void I2C_Sleep(void);
+void I2C_Wakeup(void);
+void I2C_EnableInt(void);
+void I2C_DisableInt(void);
+uint32 I2C_I2CSlaveStatus(void);
+uint32 I2C_I2CSlaveClearReadStatus(void);
+uint32 I2C_I2CSlaveClearWriteStatus(void);
+void I2C_I2CSlaveInitReadBuf(uint8 *rdBuf, uint32 bufSize);
+void I2C_I2CSlaveInitWriteBuf(uint8 *wrBuf, uint32 bufSize);
+uint32 I2C_I2CSlaveGetReadBufSize(void);
+uint32 I2C_I2CSlaveGetWriteBufSize(void);
+void I2C_I2CSlaveClearReadBuf(void);
+void I2C_I2CSlaveClearWriteBuf(void);
+
+/* Pins */
+#define DISCON_LED_DM_ALG_HIZ 0u
+#define CONNECT_LED_DM_ALG_HIZ 0u
+#define ADV_LED_DM_ALG_HIZ 0u
+void DISCON_LED_Write(uint8 value);
+void CONNECT_LED_Write(uint8 value);
+void ADV_LED_Write(uint8 value);
+void DISCON_LED_SetDriveMode(uint8 mode);
+void CONNECT_LED_SetDriveMode(uint8 mode);
+void ADV_LED_SetDriveMode(uint8 mode);
+
+/* The DATA_READY output to the launcher is part of the simulated schematic */
+#define CY_PINS_DATA_READY_H
+void DATA_READY_Write(uint8 value);
+
+#include "cyapicallbacks.h"